@@ -5,6 +5,9 @@
 #include <cassert>
 #include <algorithm>
 #include <type_traits>
+#include <functional>
+#include <vector>
+#include "radix_sort.h"
 
 template <class T>
 concept Arrayable = std::is_default_constructible_v<T>;
@@ -78,6 +81,26 @@ public:
         return _size;
     }
 
+    size_t capacity() const {
+        return _capacity;
+    }
+
+    T* begin() {
+        return _array.get();
+    }
+
+    T* end() {
+        return _array.get() + _size;
+    }
+
+    const T* begin() const {
+        return _array.get();
+    }
+
+    const T* end() const {
+        return _array.get() + _size;
+    }
+
     void push_back(const T& value) {
         if (_size >= _capacity){
             if (_capacity == 0){
@@ -111,29 +134,97 @@ public:
     template <typename U>
     static constexpr bool has_arrow = requires(const U& u) { u->area(); };
 
+    static double areaOf(const T& value) {
+        if constexpr (std::is_pointer_v<T> || has_arrow<T>) {
+            return value ? value->area() : 0.0;
+        } else {
+            return value.area();
+        }
+    }
+
+    struct AreaKey {
+        double operator()(const T& value) const {
+            return areaOf(value);
+        }
+    };
+
     double totalArea() const {
         double total = 0.0;
         for (size_t i = 0; i < _size; i++) {
-            if constexpr (std::is_pointer_v<T>) {
-                if (_array[i]) {
-                    total += _array[i]->area();
-                }
-            } else if constexpr (has_arrow<T>) {
-                if (_array[i]) {
-                    total += _array[i]->area();
-                }
-            } else {
-                total += _array[i].area();
-            }
+            total += areaOf(_array[i]);
         }
         return total;
     }
 
+    // Key is called concurrently from several threads; threads == 0 uses all hardware threads.
+    template <class Key = AreaKey>
+    std::vector<size_t> sortedIndices(Key key = {}, unsigned threads = 0) const {
+        return sortedOrder(extractKeys(key, threads), threads);
+    }
+
+    // Key is called concurrently from several threads; an exception it throws propagates here
+    // and leaves the array unchanged.
+    template <class Key = AreaKey>
+    void sortBy(Key key = {}, unsigned threads = 0) {
+        auto order = sortedIndices(key, threads);
+        auto sorted = std::shared_ptr<T[]>(new T[_capacity]);
+        for (size_t i = 0; i < _size; i++) {
+            sorted[i] = std::move(_array[order[i]]);
+        }
+        _array = std::move(sorted);
+    }
+
+    // Key is called concurrently from several threads, as in sortedIndices.
+    template <class Key = AreaKey>
+    Array topK(size_t k, Key key = {}, unsigned threads = 0) const {
+        auto keys = extractKeys(key, threads);
+        std::vector<size_t> order(_size);
+        for (size_t i = 0; i < _size; i++) {
+            order[i] = i;
+        }
+
+        k = std::min(k, _size);
+        auto larger = [&keys](size_t a, size_t b) {
+            return keys[b] < keys[a] || (!(keys[a] < keys[b]) && a < b);
+        };
+        if (k < _size) {
+            std::nth_element(order.begin(), order.begin() + k, order.end(), larger);
+        }
+        std::sort(order.begin(), order.begin() + k, larger);
+
+        Array result;
+        result.resize(k);
+        for (size_t i = 0; i < k; i++) {
+            result.push_back(_array[order[i]]);
+        }
+        return result;
+    }
+
     ~Array() noexcept {
     }
 
 private:
 
+    template <class Key>
+    auto extractKeys(Key& key, unsigned threads) const {
+        using K = std::remove_cvref_t<std::invoke_result_t<Key&, const T&>>;
+        std::vector<K> keys;
+        if constexpr (std::is_default_constructible_v<K>) {
+            keys.resize(_size);
+            forEachShare(_size, shareCount(_size, threads), [&](unsigned, size_t first, size_t count) {
+                for (size_t i = first; i < first + count; i++) {
+                    keys[i] = std::invoke(key, _array[i]);
+                }
+            });
+        } else {
+            keys.reserve(_size);
+            for (size_t i = 0; i < _size; i++) {
+                keys.push_back(std::invoke(key, _array[i]));
+            }
+        }
+        return keys;
+    }
+
     void resize(size_t new_capacity) {
         auto new_array = std::shared_ptr<T[]>(new T[new_capacity]);
 
@@ -0,0 +1,199 @@
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <list>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#endif
+
+template <class T>
+concept Spillable = std::is_default_constructible_v<T> && std::is_trivially_copyable_v<T>;
+
+// Collection made of fixed-size chunks that never relocate. At most maxResidentChunks chunks
+// are kept in memory; the least recently used ones are written to a temporary file.
+// References returned by operator[] stay valid only until another chunk is loaded.
+template <Spillable T, size_t ChunkSize = 4096>
+class ChunkedArray {
+public:
+    explicit ChunkedArray(size_t maxResidentChunks = 16) : _maxResident(maxResidentChunks) {
+        if (maxResidentChunks < 2) {
+            throw std::invalid_argument("At least two chunks must fit in the cache.");
+        }
+    }
+
+    ChunkedArray(const ChunkedArray&) = delete;
+    ChunkedArray& operator=(const ChunkedArray&) = delete;
+    ChunkedArray(ChunkedArray&&) noexcept = default;
+    ChunkedArray& operator=(ChunkedArray&&) noexcept = default;
+
+    T& operator[](size_t index) {
+        assert(index < _size);
+        return load(index / ChunkSize, true)[index % ChunkSize];
+    }
+
+    const T& operator[](size_t index) const {
+        assert(index < _size);
+        return load(index / ChunkSize, false)[index % ChunkSize];
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    size_t residentChunks() const {
+        return _lru.size();
+    }
+
+    void push_back(const T& value) {
+        size_t chunk = _size / ChunkSize;
+        if (chunk == _chunks.size()) {
+            _chunks.emplace_back();
+        }
+        load(chunk, true)[_size % ChunkSize] = value;
+        ++_size;
+    }
+
+    void erase(size_t index) {
+        assert(index < _size);
+        const size_t last = (_size - 1) / ChunkSize;
+
+        for (size_t c = index / ChunkSize; c <= last; c++) {
+            T* data = load(c, true);
+            size_t begin = (c == index / ChunkSize) ? index % ChunkSize : 0;
+            size_t end = (c == last) ? (_size - 1) % ChunkSize + 1 : ChunkSize;
+
+            std::copy(data + begin + 1, data + end, data + begin);
+            if (c < last) {
+                T carry = load(c + 1, false)[0];
+                load(c, true)[end - 1] = carry;
+            }
+        }
+
+        --_size;
+        if (_size % ChunkSize == 0) {
+            release(last);
+            _chunks.pop_back();
+        }
+    }
+
+    template <class F>
+    void forEachChunk(F f) const {
+        for (size_t c = 0; c < _chunks.size(); c++) {
+            size_t count = (c + 1 == _chunks.size()) ? _size - c * ChunkSize : ChunkSize;
+            f(load(c, false), count);
+        }
+    }
+
+    double totalArea() const {
+        double total = 0.0;
+        forEachChunk([&total](const T* data, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                total += data[i].area();
+            }
+        });
+        return total;
+    }
+
+private:
+    struct Chunk {
+        std::unique_ptr<T[]> data;
+        bool dirty = false;
+        bool onDisk = false;
+        std::list<size_t>::iterator lru;
+    };
+
+    struct FileCloser {
+        void operator()(std::FILE* file) const { std::fclose(file); }
+    };
+
+    T* load(size_t c, bool write) const {
+        Chunk& chunk = _chunks[c];
+        if (chunk.data) {
+            _lru.splice(_lru.begin(), _lru, chunk.lru);
+        } else {
+            std::unique_ptr<T[]> buffer;
+            if (_lru.size() >= _maxResident) {
+                buffer = evict(_lru.back());
+            } else {
+                buffer = std::make_unique<T[]>(ChunkSize);
+            }
+
+            if (chunk.onDisk) {
+                seek(c);
+                if (std::fread(buffer.get(), sizeof(T), ChunkSize, _file.get()) != ChunkSize) {
+                    throw std::runtime_error("Failed to read chunk from spill file.");
+                }
+            }
+            chunk.data = std::move(buffer);
+            _lru.push_front(c);
+            chunk.lru = _lru.begin();
+        }
+        chunk.dirty = chunk.dirty || write;
+        return chunk.data.get();
+    }
+
+    std::unique_ptr<T[]> evict(size_t c) const {
+        Chunk& chunk = _chunks[c];
+        if (chunk.dirty) {
+            if (!_file) {
+                _file.reset(std::tmpfile());
+                if (!_file) {
+                    throw std::runtime_error("Failed to create spill file.");
+                }
+            }
+            seek(c);
+            if (std::fwrite(chunk.data.get(), sizeof(T), ChunkSize, _file.get()) != ChunkSize) {
+                throw std::runtime_error("Failed to write chunk to spill file.");
+            }
+            chunk.dirty = false;
+            chunk.onDisk = true;
+        }
+        _lru.erase(chunk.lru);
+        return std::move(chunk.data);
+    }
+
+    void release(size_t c) {
+        Chunk& chunk = _chunks[c];
+        if (chunk.data) {
+            _lru.erase(chunk.lru);
+            chunk.data.reset();
+        }
+    }
+
+    // Spill files may exceed 2 GiB, so plain fseek with a long offset is not enough.
+    void seek(size_t c) const {
+#ifdef _WIN32
+        using Offset = __int64;
+#else
+        using Offset = off_t;
+#endif
+        const uint64_t offset = static_cast<uint64_t>(c) * ChunkSize * sizeof(T);
+        if (offset > static_cast<uint64_t>(std::numeric_limits<Offset>::max())) {
+            throw std::overflow_error("Spill file offset does not fit in the platform file offset.");
+        }
+#ifdef _WIN32
+        int result = _fseeki64(_file.get(), static_cast<Offset>(offset), SEEK_SET);
+#else
+        int result = fseeko(_file.get(), static_cast<Offset>(offset), SEEK_SET);
+#endif
+        if (result != 0) {
+            throw std::runtime_error("Failed to seek in spill file.");
+        }
+    }
+
+    size_t _size = 0;
+    size_t _maxResident;
+    mutable std::vector<Chunk> _chunks;
+    mutable std::list<size_t> _lru;
+    mutable std::unique_ptr<std::FILE, FileCloser> _file;
+};
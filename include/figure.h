@@ -2,11 +2,55 @@
 #pragma once
 
 #include "point.h"
+#include <algorithm>
 #include <memory>
 #include <vector>
 #include <stdexcept>
 #include <typeinfo> 
 #include <cmath>
+#include <cassert>
+#include <limits>
+#include <iterator>
+#include <ranges>
+
+template <Number T>
+class VertexView;
+
+// True when every point within rx, ry of the centre is representable in T, so a figure's vertices
+// can be computed without overflow or an out-of-range conversion. NaN never fits.
+template <Number T>
+bool extentFits(const Point<T>& c, double rx, double ry) {
+    double low = static_cast<double>(std::numeric_limits<T>::lowest());
+    double high = static_cast<double>(std::numeric_limits<T>::max());
+    auto fits = [&](double v) {
+        if constexpr (std::is_integral_v<T>) {
+            // max() may round up to 2^digits in double, which is itself out of range.
+            return v >= low && v < std::ldexp(1.0, std::numeric_limits<T>::digits);
+        } else {
+            return v >= low && v <= high;
+        }
+    };
+    double x = c.getX();
+    double y = c.getY();
+    return fits(x - rx) && fits(x + rx) && fits(y - ry) && fits(y + ry);
+}
+
+// Edge normals of a regular polygon and its apothem, both for a unit circumradius.
+template <size_t N>
+struct PolygonNormals {
+    double cos[N];
+    double sin[N];
+    double apothem;
+};
+
+template <size_t N>
+inline bool insideRegularPolygon(const PolygonNormals<N>& normals, double dx, double dy, double radius) {
+    double reach = dx * normals.cos[0] + dy * normals.sin[0];
+    for (size_t k = 1; k < N; k++) {
+        reach = std::max(reach, dx * normals.cos[k] + dy * normals.sin[k]);
+    }
+    return reach <= normals.apothem * radius * (1.0 + 1e-12);
+}
 
 template <Number T>
 
@@ -16,8 +60,21 @@ public:
     virtual ~Figure() = default;    
     virtual Point<T> getCenter() const = 0;
     virtual double area() const = 0;
-    virtual std::vector<std::unique_ptr<Point<T>>> getVertices() const = 0;
+    virtual size_t vertexCount() const = 0;
+    virtual Point<T> vertexAt(size_t index) const = 0;
+    virtual bool contains(const Point<T>& point) const = 0;
     virtual void print(std::ostream& os) const = 0;
+
+    VertexView<T> vertices() const;
+
+    virtual std::vector<std::unique_ptr<Point<T>>> getVertices() const {
+        std::vector<std::unique_ptr<Point<T>>> result;
+        result.reserve(vertexCount());
+        for (const auto& vertex : vertices()) {
+            result.push_back(std::make_unique<Point<T>>(vertex));
+        }
+        return result;
+    }
     
     virtual operator double() const {
         return area();
@@ -33,13 +90,10 @@ public:
             return false;
         }
 
-        auto vertices1 = this->getVertices();
-        auto vertices2 = other.getVertices();
+        if (vertexCount() != other.vertexCount()) return false;
         
-        if (vertices1.size() != vertices2.size()) return false;
-        
-        for (size_t i = 0; i < vertices1.size(); i++) {
-            if (!vertices1[i] || !vertices2[i] || (*vertices1[i] != *vertices2[i])){ 
+        for (size_t i = 0; i < vertexCount(); i++) {
+            if (vertexAt(i) != other.vertexAt(i)){ 
                 return false;
             }
         }
@@ -50,4 +104,60 @@ public:
     virtual bool operator!=(const Figure<T>& other) const {
         return !(*this == other);
     }
-};
\ No newline at end of file
+};
+
+template <Number T>
+class VertexView : public std::ranges::view_interface<VertexView<T>> {
+public:
+    class iterator {
+    public:
+        using iterator_concept = std::random_access_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Point<T>;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+        iterator(const Figure<T>* figure, difference_type index) : _figure(figure), _index(index) {}
+
+        Point<T> operator*() const { return _figure->vertexAt(static_cast<size_t>(_index)); }
+        Point<T> operator[](difference_type n) const { return *(*this + n); }
+
+        iterator& operator++() { ++_index; return *this; }
+        iterator operator++(int) { iterator tmp = *this; ++_index; return tmp; }
+        iterator& operator--() { --_index; return *this; }
+        iterator operator--(int) { iterator tmp = *this; --_index; return tmp; }
+        iterator& operator+=(difference_type n) { _index += n; return *this; }
+        iterator& operator-=(difference_type n) { _index -= n; return *this; }
+
+        friend iterator operator+(iterator it, difference_type n) { return it += n; }
+        friend iterator operator+(difference_type n, iterator it) { return it += n; }
+        friend iterator operator-(iterator it, difference_type n) { return it -= n; }
+        friend difference_type operator-(const iterator& lhs, const iterator& rhs) { return lhs._index - rhs._index; }
+
+        friend bool operator==(const iterator& lhs, const iterator& rhs) { return lhs._index == rhs._index; }
+        friend auto operator<=>(const iterator& lhs, const iterator& rhs) { return lhs._index <=> rhs._index; }
+
+    private:
+        const Figure<T>* _figure = nullptr;
+        difference_type _index = 0;
+    };
+
+    VertexView() = default;
+    explicit VertexView(const Figure<T>& figure) : _figure(&figure), _count(figure.vertexCount()) {}
+
+    iterator begin() const { return iterator(_figure, 0); }
+    iterator end() const { return iterator(_figure, static_cast<std::ptrdiff_t>(_count)); }
+    size_t size() const { return _count; }
+
+private:
+    const Figure<T>* _figure = nullptr;
+    size_t _count = 0;
+};
+
+template <Number T>
+inline constexpr bool std::ranges::enable_borrowed_range<VertexView<T>> = true;
+
+template <Number T>
+VertexView<T> Figure<T>::vertices() const {
+    return VertexView<T>(*this);
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+
+#pragma once
+
+#include "shape_registry.h"
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+// Flat, trivially copyable form of a registered figure, used wherever figures leave the heap.
+template <Number T>
+struct FigureRecord {
+    ShapeId id = 0;
+    T params[kMaxShapeParams] = {};
+
+    static FigureRecord of(const Figure<T>& figure) {
+        const auto& registry = ShapeRegistry<T>::instance();
+        auto id = registry.idOf(figure);
+        if (!id) {
+            throw std::invalid_argument("Figure type is not registered.");
+        }
+        FigureRecord record;
+        record.id = *id;
+        registry.extract(*id, figure, record.params);
+        return record;
+    }
+
+    const ShapeKind<T>& kind() const {
+        return ShapeRegistry<T>::instance().kind(id);
+    }
+
+    double area() const {
+        return kind().area(params);
+    }
+
+    std::shared_ptr<Figure<T>> toFigure() const {
+        return ShapeRegistry<T>::instance().make(id, params);
+    }
+
+    friend bool operator==(const FigureRecord& lhs, const FigureRecord& rhs) {
+        return lhs.id == rhs.id && std::equal(lhs.params, lhs.params + kMaxShapeParams, rhs.params);
+    }
+};
+
+static_assert(std::is_trivially_copyable_v<FigureRecord<double>>);
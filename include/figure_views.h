@@ -0,0 +1,15 @@
+
+#pragma once
+
+#include "figure.h"
+#include <memory>
+#include <ranges>
+
+template <class Shape>
+inline constexpr auto ofType = std::views::filter([](const auto& figure) {
+    return dynamic_cast<const Shape*>(std::to_address(figure)) != nullptr;
+});
+
+inline constexpr auto areas = std::views::transform([](const auto& figure) {
+    return figure->area();
+});
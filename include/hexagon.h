@@ -22,6 +22,9 @@ public:
             if (_radius <= 0){ 
                 throw std::invalid_argument("Radius must be positive.");
             }
+            if (!extentFits(_center, _radius, _radius)) {
+                throw std::invalid_argument("Hexagon does not fit in the coordinate type.");
+            }
         }
 
     Hexagon(const Hexagon& other)
@@ -45,37 +48,59 @@ public:
         return *this;
     }
 
-    Point<T> getCenter() const override { return *center; }
-    double area() const override {
-        return (3.0 * std::sqrt(3.0) * radius * radius) / 2.0;
+    static double computeArea(T r) {
+        return (3.0 * std::sqrt(3.0) * r * r) / 2.0;
     }
 
-    std::vector<std::unique_ptr<Point<T>>> getVertices() const override {
-        std::vector<std::unique_ptr<Point<T>>> vertices;
+    static Point<T> computeVertex(const Point<T>& c, T r, size_t index) {
         const int N = 6;
-        
-        for (int i = 0; i < N; i++) {
-            double angle = 2.0 * M_PI * i / N - M_PI / 6.0; 
-            T x = center->getX() + radius * std::cos(angle);
-            T y = center->getY() + radius * std::sin(angle);
-            vertices.push_back(std::make_unique<Point<T>>(x, y));
-        }
-        
-        return vertices;
+
+        double angle = 2.0 * M_PI * index / N - M_PI / 6.0; 
+        T x = c.getX() + r * std::cos(angle);
+        T y = c.getY() + r * std::sin(angle);
+        return Point<T>(x, y);
     }
 
-    void print(std::ostream& os) const override {
+    // Normals point at 0, 60, 120, 180, 240 and 300 degrees; the apothem is cos(30 degrees).
+    static constexpr PolygonNormals<6> kNormals = {
+        {1.0, 0.5, -0.5, -1.0, -0.5, 0.5},
+        {0.0, 0.8660254037844386, 0.8660254037844386, 0.0, -0.8660254037844386, -0.8660254037844386},
+        0.8660254037844386};
+
+    static bool computeContains(const Point<T>& c, T r, double x, double y) {
+        return insideRegularPolygon(kNormals, x - c.getX(), y - c.getY(), r);
+    }
 
-        auto vertices = getVertices();
-        os << "Hexagon (R=" << radius << ")";
+    T getRadius() const { return radius; }
 
-        for (size_t i = 0; i < vertices.size(); i++) {
-            os << *vertices[i];
-            if (i < vertices.size()-1){
+    Point<T> getCenter() const override { return *center; }
+    double area() const override {
+        return computeArea(radius);
+    }
+
+    size_t vertexCount() const override { return 6; }
+
+    Point<T> vertexAt(size_t index) const override {
+        assert(index < 6);
+        return computeVertex(*center, radius, index);
+    }
+
+    bool contains(const Point<T>& point) const override {
+        return computeContains(*center, radius, point.getX(), point.getY());
+    }
+
+    static void computePrint(std::ostream& os, const Point<T>& c, T r) {
+        os << "Hexagon (R=" << r << ")";
+        for (size_t i = 0; i < 6; i++) {
+            os << computeVertex(c, r, i);
+            if (i < 5){
                 os<<" ";
             }
         }
+        os << "Area:" << computeArea(r) << "Center:" << c;
+    }
 
-        os << "Area:" << area() << "Center:" << getCenter();
+    void print(std::ostream& os) const override {
+        computePrint(os, *center, radius);
     }
 };
\ No newline at end of file
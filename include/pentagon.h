@@ -25,6 +25,9 @@ public:
             if (_radius <= 0){ 
                 throw std::invalid_argument("Radius must be positive");
             }
+            if (!extentFits(_center, _radius, _radius)) {
+                throw std::invalid_argument("Pentagon does not fit in the coordinate type.");
+            }
         }
 
     Pentagon(const Pentagon& other)
@@ -50,37 +53,59 @@ public:
         return *this;
     }
 
+    static double computeArea(T r) {
+        return (5.0 * r * r * std::sin(2.0 * M_PI / 5.0)) / 2.0;
+    }
+
+    static Point<T> computeVertex(const Point<T>& c, T r, size_t index) {
+        const int N = 5;
+
+        double angle = 2.0 * M_PI * index / N - M_PI / 2.0; 
+        T x = c.getX() + r * std::cos(angle);
+        T y = c.getY() + r * std::sin(angle);
+        return Point<T>(x, y);
+    }
+
+    // Normals point at -54, 18, 90, 162 and 234 degrees; the apothem is cos(36 degrees).
+    static constexpr PolygonNormals<5> kNormals = {
+        {0.5877852522924731, 0.9510565162951535, 0.0, -0.9510565162951535, -0.5877852522924731},
+        {-0.8090169943749475, 0.3090169943749474, 1.0, 0.3090169943749474, -0.8090169943749475},
+        0.8090169943749475};
+
+    static bool computeContains(const Point<T>& c, T r, double x, double y) {
+        return insideRegularPolygon(kNormals, x - c.getX(), y - c.getY(), r);
+    }
+
+    T getRadius() const { return radius; }
+
     Point<T> getCenter() const override { return *center; }
     double area() const override {
-        return (5.0 * radius * radius * std::sin(2.0 * M_PI / 5.0)) / 2.0;
+        return computeArea(radius);
     }
 
-    std::vector<std::unique_ptr<Point<T>>> getVertices() const override {
-        std::vector<std::unique_ptr<Point<T>>> vertices;
+    size_t vertexCount() const override { return 5; }
 
-        const int N = 5;
-        
-        for (int i = 0; i < N; i++) {
-            double angle = 2.0 * M_PI * i / N - M_PI / 2.0; 
-            T x = center->getX() + radius * std::cos(angle);
-            T y = center->getY() + radius * std::sin(angle);
-            vertices.push_back(std::make_unique<Point<T>>(x, y));
-        }
-        
-        return vertices;
+    Point<T> vertexAt(size_t index) const override {
+        assert(index < 5);
+        return computeVertex(*center, radius, index);
     }
 
-    void print(std::ostream& os) const override {
-
-        auto vertices = getVertices();
-        os << "Pentagon (R=" << radius << ")";
+    bool contains(const Point<T>& point) const override {
+        return computeContains(*center, radius, point.getX(), point.getY());
+    }
 
-        for (size_t i = 0; i < vertices.size(); i++) {
-            os << *vertices[i];
-            if (i< vertices.size()-1){
+    static void computePrint(std::ostream& os, const Point<T>& c, T r) {
+        os << "Pentagon (R=" << r << ")";
+        for (size_t i = 0; i < 5; i++) {
+            os << computeVertex(c, r, i);
+            if (i < 4){
                 os<<" ";
             }
         }
-        os << "Area:" << area() << "Center:" << getCenter();
+        os << "Area:" << computeArea(r) << "Center:" << c;
+    }
+
+    void print(std::ostream& os) const override {
+        computePrint(os, *center, radius);
     }
 };
\ No newline at end of file
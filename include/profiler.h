@@ -0,0 +1,142 @@
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <ostream>
+#include <string>
+
+// Log-linear latency histogram in the style of HdrHistogram: each power of two is split into
+// 16 buckets, so recorded values keep about 6% relative precision at any magnitude.
+class LatencyHistogram {
+public:
+    void record(uint64_t value) {
+        _counts[bucketOf(value)]++;
+        _count++;
+        _sum += value;
+        _min = std::min(_min, value);
+        _max = std::max(_max, value);
+    }
+
+    uint64_t count() const { return _count; }
+    uint64_t min() const { return _count ? _min : 0; }
+    uint64_t max() const { return _max; }
+
+    double mean() const {
+        return _count ? static_cast<double>(_sum) / _count : 0.0;
+    }
+
+    // Upper bound of the bucket holding the given percentile, clamped to the recorded range.
+    uint64_t percentile(double p) const {
+        if (_count == 0) {
+            return 0;
+        }
+        auto rank = static_cast<uint64_t>(p / 100.0 * _count + 0.5);
+        rank = std::clamp<uint64_t>(rank, 1, _count);
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBuckets; i++) {
+            seen += _counts[i];
+            if (seen >= rank) {
+                return std::clamp(upperBound(i), min(), _max);
+            }
+        }
+        return _max;
+    }
+
+private:
+    static constexpr unsigned kSubBits = 4;
+    static constexpr uint64_t kSub = uint64_t(1) << kSubBits;
+    static constexpr size_t kBuckets = (64 - kSubBits + 1) * kSub;
+
+    static size_t bucketOf(uint64_t value) {
+        if (value < kSub) {
+            return static_cast<size_t>(value);
+        }
+        unsigned shift = std::bit_width(value) - kSubBits - 1;
+        return (shift + 1) * kSub + ((value >> shift) & (kSub - 1));
+    }
+
+    static uint64_t upperBound(size_t bucket) {
+        if (bucket < kSub) {
+            return bucket;
+        }
+        unsigned shift = static_cast<unsigned>(bucket / kSub) - 1;
+        uint64_t lower = (kSub + bucket % kSub) << shift;
+        return lower + ((uint64_t(1) << shift) - 1);
+    }
+
+    std::array<uint64_t, kBuckets> _counts{};
+    uint64_t _count = 0;
+    uint64_t _sum = 0;
+    uint64_t _min = std::numeric_limits<uint64_t>::max();
+    uint64_t _max = 0;
+};
+
+class Profiler {
+public:
+    LatencyHistogram& histogram(const std::string& name) {
+        return _histograms[name];
+    }
+
+    void report(std::ostream& os) const {
+        os << "\nPROFILE REPORT (microseconds)" << std::endl;
+        os << std::left << std::setw(16) << "operation" << std::right
+           << std::setw(10) << "count" << std::setw(12) << "min" << std::setw(12) << "p50"
+           << std::setw(12) << "p90" << std::setw(12) << "p99" << std::setw(12) << "max"
+           << std::setw(12) << "mean" << std::endl;
+
+        auto flags = os.flags();
+        auto precision = os.precision();
+        os << std::fixed << std::setprecision(2);
+        for (const auto& [name, h] : _histograms) {
+            if (h.count() == 0) {
+                continue;
+            }
+            os << std::left << std::setw(16) << name << std::right
+               << std::setw(10) << h.count() << std::setw(12) << micros(h.min())
+               << std::setw(12) << micros(h.percentile(50)) << std::setw(12) << micros(h.percentile(90))
+               << std::setw(12) << micros(h.percentile(99)) << std::setw(12) << micros(h.max())
+               << std::setw(12) << h.mean() / 1000.0 << std::endl;
+        }
+        os.flags(flags);
+        os.precision(precision);
+    }
+
+private:
+    static double micros(uint64_t nanoseconds) {
+        return nanoseconds / 1000.0;
+    }
+
+    std::map<std::string, LatencyHistogram> _histograms;
+};
+
+// Records the lifetime of the scope in nanoseconds; does nothing when given no histogram.
+class ProfileScope {
+public:
+    explicit ProfileScope(LatencyHistogram* histogram) : _histogram(histogram) {
+        if (_histogram) {
+            _start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+    ~ProfileScope() {
+        if (_histogram) {
+            auto elapsed = std::chrono::steady_clock::now() - _start;
+            _histogram->record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        }
+    }
+
+private:
+    LatencyHistogram* _histogram;
+    std::chrono::steady_clock::time_point _start;
+};
@@ -0,0 +1,160 @@
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <exception>
+#include <numeric>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+template <class K>
+concept RadixKey = std::is_arithmetic_v<K>;
+
+template <RadixKey K>
+uint64_t radixBits(K key) {
+    if constexpr (std::is_floating_point_v<K>) {
+        // Adding +0.0 folds -0.0 into +0.0 so equal keys keep their relative order.
+        uint64_t bits = std::bit_cast<uint64_t>(static_cast<double>(key) + 0.0);
+        return (bits & (uint64_t(1) << 63)) ? ~bits : bits | (uint64_t(1) << 63);
+    } else if constexpr (std::is_signed_v<K>) {
+        return static_cast<uint64_t>(static_cast<int64_t>(key)) ^ (uint64_t(1) << 63);
+    } else {
+        return static_cast<uint64_t>(key);
+    }
+}
+
+// Below this many elements per thread the work is not worth a thread start.
+inline constexpr size_t kMinShare = size_t(1) << 15;
+
+// Number of contiguous shares to split n elements into; threads == 0 means all hardware threads.
+inline unsigned shareCount(size_t n, unsigned threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    return static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(threads, n / kMinShare)));
+}
+
+// Calls f(share, first, count) for each contiguous share of [0, n), one thread per share.
+// An exception thrown by f, or by starting a thread, is rethrown here once every started
+// thread has been joined; if several shares throw, the lowest share's exception wins.
+template <class F>
+void forEachShare(size_t n, unsigned shares, F f) {
+    if (shares <= 1) {
+        f(0u, size_t{0}, n);
+        return;
+    }
+    const size_t share = (n + shares - 1) / shares;
+    std::vector<std::exception_ptr> errors(shares);
+    std::vector<std::thread> workers;
+    workers.reserve(shares);
+    auto joinAll = [&workers] {
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    };
+
+    try {
+        for (unsigned s = 0; s < shares; s++) {
+            size_t first = std::min(n, s * share);
+            size_t count = std::min(share, n - first);
+            workers.emplace_back([&f, &errors, s, first, count] {
+                try {
+                    f(s, first, count);
+                } catch (...) {
+                    errors[s] = std::current_exception();
+                }
+            });
+        }
+    } catch (...) {
+        joinAll();
+        throw;
+    }
+    joinAll();
+
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+// Stable LSD radix sort over 8-bit digits; digits shared by every key are skipped.
+// Each pass counts and scatters contiguous shares in parallel; the per-share offsets are laid
+// out share by share within a digit, which keeps the sort stable.
+template <RadixKey K>
+std::vector<size_t> radixSortedOrder(const std::vector<K>& keys, unsigned threads = 0) {
+    struct Entry {
+        uint64_t bits;
+        size_t index;
+    };
+
+    const size_t n = keys.size();
+    const unsigned shares = shareCount(n, threads);
+    std::vector<Entry> entries(n);
+    std::vector<Entry> buffer(n);
+    forEachShare(n, shares, [&](unsigned, size_t first, size_t count) {
+        for (size_t i = first; i < first + count; i++) {
+            entries[i] = Entry{radixBits(keys[i]), i};
+        }
+    });
+
+    std::vector<std::array<size_t, 256>> counts(shares);
+    for (unsigned shift = 0; shift < 64; shift += 8) {
+        forEachShare(n, shares, [&](unsigned s, size_t first, size_t count) {
+            counts[s].fill(0);
+            for (size_t i = first; i < first + count; i++) {
+                counts[s][(entries[i].bits >> shift) & 0xFF]++;
+            }
+        });
+
+        size_t offset = 0;
+        bool skip = false;
+        for (size_t digit = 0; digit < 256; digit++) {
+            size_t start = offset;
+            for (auto& c : counts) {
+                size_t count = c[digit];
+                c[digit] = offset;
+                offset += count;
+            }
+            skip = skip || offset - start == n;
+        }
+        if (n == 0 || skip) {
+            continue;
+        }
+
+        forEachShare(n, shares, [&](unsigned s, size_t first, size_t count) {
+            auto& next = counts[s];
+            for (size_t i = first; i < first + count; i++) {
+                buffer[next[(entries[i].bits >> shift) & 0xFF]++] = entries[i];
+            }
+        });
+        entries.swap(buffer);
+    }
+
+    std::vector<size_t> order(n);
+    forEachShare(n, shares, [&](unsigned, size_t first, size_t count) {
+        for (size_t i = first; i < first + count; i++) {
+            order[i] = entries[i].index;
+        }
+    });
+    return order;
+}
+
+template <class K>
+std::vector<size_t> sortedOrder(const std::vector<K>& keys, unsigned threads = 0) {
+    if constexpr (RadixKey<K>) {
+        return radixSortedOrder(keys, threads);
+    } else {
+        std::vector<size_t> order(keys.size());
+        std::iota(order.begin(), order.end(), size_t{0});
+        std::stable_sort(order.begin(), order.end(), [&keys](size_t a, size_t b) {
+            return keys[a] < keys[b];
+        });
+        return order;
+    }
+}
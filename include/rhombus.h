@@ -5,6 +5,7 @@
 #include <memory>
 #include <vector>
 #include <stdexcept>
+#include <cmath>
 
 template <Number T>
 
@@ -29,6 +30,9 @@ public:
               if (h_diag <= 0 || v_diag <= 0){ 
                 throw std::invalid_argument("Diagonals must be positive.");
               }
+              if (!extentFits(_center, h_diag / 2.0, v_diag / 2.0)) {
+                throw std::invalid_argument("Rhombus does not fit in the coordinate type.");
+              }
           }
 
     Rhombus(const Rhombus& other)
@@ -58,31 +62,57 @@ public:
         return *this;
     }
 
+    static double computeArea(T h_diag, T v_diag) {
+        return static_cast<double>(h_diag) * v_diag / 2.0;
+    }
+
+    static Point<T> computeVertex(const Point<T>& c, T h_diag, T v_diag, size_t index) {
+        T half_h = h_diag / 2;
+        T half_v = v_diag / 2;
+
+        switch (index) {
+            case 0: return Point<T>(c.getX(), c.getY() + half_v);
+            case 1: return Point<T>(c.getX() + half_h, c.getY());
+            case 2: return Point<T>(c.getX(), c.getY() - half_v);
+            default: return Point<T>(c.getX() - half_h, c.getY());
+        }
+    }
+
+    static bool computeContains(const Point<T>& c, T h_diag, T v_diag, double x, double y) {
+        double dx = std::abs(x - c.getX());
+        double dy = std::abs(y - c.getY());
+        return dx * v_diag + dy * h_diag <= (static_cast<double>(h_diag) * v_diag) / 2.0;
+    }
+
+    T getHorizontalDiagonal() const { return horizontal_diagonal; }
+    T getVerticalDiagonal() const { return vertical_diagonal; }
+
     Point<T> getCenter() const override { return *center; }
-    double area() const override { return (horizontal_diagonal * vertical_diagonal) / 2.0; }
-
-    std::vector<std::unique_ptr<Point<T>>> getVertices() const override {
-        std::vector<std::unique_ptr<Point<T>>> vertices;
-        T half_h = horizontal_diagonal / 2;
-        T half_v = vertical_diagonal / 2;
-        
-        vertices.push_back(std::make_unique<Point<T>>(center->getX(), center->getY() + half_v));
-        vertices.push_back(std::make_unique<Point<T>>(center->getX() + half_h, center->getY()));
-        vertices.push_back(std::make_unique<Point<T>>(center->getX(), center->getY() - half_v));
-        vertices.push_back(std::make_unique<Point<T>>(center->getX() - half_h, center->getY()));
-            
-        return vertices;
+    double area() const override { return computeArea(horizontal_diagonal, vertical_diagonal); }
+
+    size_t vertexCount() const override { return 4; }
+
+    Point<T> vertexAt(size_t index) const override {
+        assert(index < 4);
+        return computeVertex(*center, horizontal_diagonal, vertical_diagonal, index);
     }
 
-    void print(std::ostream& os) const override {
-        auto vertices = getVertices();
-        os << "Rhombus (d1=" << horizontal_diagonal << ", d2=" << vertical_diagonal << ")";
-        for (size_t i = 0; i < vertices.size(); i++) {
-            os << *vertices[i];
-            if (i< vertices.size()-1){
+    bool contains(const Point<T>& point) const override {
+        return computeContains(*center, horizontal_diagonal, vertical_diagonal, point.getX(), point.getY());
+    }
+
+    static void computePrint(std::ostream& os, const Point<T>& c, T h_diag, T v_diag) {
+        os << "Rhombus (d1=" << h_diag << ", d2=" << v_diag << ")";
+        for (size_t i = 0; i < 4; i++) {
+            os << computeVertex(c, h_diag, v_diag, i);
+            if (i < 3){
                 os<<", ";
             }
         }
-        os << "Area: " << area() << " Center: " << getCenter();
+        os << "Area: " << computeArea(h_diag, v_diag) << " Center: " << c;
+    }
+
+    void print(std::ostream& os) const override {
+        computePrint(os, *center, horizontal_diagonal, vertical_diagonal);
     }
 };
\ No newline at end of file
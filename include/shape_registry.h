@@ -0,0 +1,413 @@
+
+#pragma once
+
+#include "figure.h"
+#include "rhombus.h"
+#include "pentagon.h"
+#include "hexagon.h"
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <istream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+using ShapeId = uint16_t;
+
+inline constexpr size_t kMaxShapeParams = 8;
+
+// A single figure's parameters are stored flat: params[0], params[1] are the centre, the rest are
+// named by the kind. The batch kernels (areas, classify) instead read a group of figures from one
+// contiguous column per parameter: columns[k][i] is parameter k of figure i.
+template <Number T>
+struct ShapeKind {
+    std::string name;
+    std::vector<std::string> params;
+    size_t vertexCount = 0;
+
+    double (*area)(const T* params) = nullptr;
+    void (*areas)(const T* const* columns, size_t first, size_t count, double* out) = nullptr;
+    Point<T> (*vertex)(const T* params, size_t index) = nullptr;
+    bool (*contains)(const T* params, double x, double y) = nullptr;
+    void (*classify)(const T* const* columns, const size_t* order, size_t count,
+                     const double* xs, const double* ys, size_t points, size_t* out) = nullptr;
+    void (*print)(std::ostream& os, const ShapeKind& kind, const T* params) = nullptr;
+    std::shared_ptr<Figure<T>> (*make)(ShapeId id, const T* params) = nullptr;
+
+    // Returns false for parameters the shape cannot be built from. When unset, every parameter
+    // after the centre must be finite and positive.
+    bool (*validate)(const T* params) = nullptr;
+
+    const std::type_info* type = nullptr;
+    void (*extract)(const Figure<T>& figure, T* params) = nullptr;
+
+    size_t stride() const {
+        return params.size();
+    }
+};
+
+template <Number T>
+class ShapeRegistry;
+
+template <Number T>
+class RegisteredFigure : public Figure<T> {
+public:
+    RegisteredFigure(ShapeId id, const T* params) : _id(id), _params{} {
+        const auto& shape = kind();
+        std::copy(params, params + shape.stride(), _params.begin());
+        if (shape.validate ? !shape.validate(_params.data()) : !positiveParams(shape, _params.data())) {
+            throw std::invalid_argument("Invalid parameters for " + shape.name + ".");
+        }
+    }
+
+    ShapeId shapeId() const { return _id; }
+    const T* params() const { return _params.data(); }
+
+    Point<T> getCenter() const override { return Point<T>(_params[0], _params[1]); }
+    double area() const override { return kind().area(_params.data()); }
+    size_t vertexCount() const override { return kind().vertexCount; }
+
+    Point<T> vertexAt(size_t index) const override {
+        assert(index < kind().vertexCount);
+        return kind().vertex(_params.data(), index);
+    }
+
+    bool contains(const Point<T>& point) const override {
+        return kind().contains(_params.data(), point.getX(), point.getY());
+    }
+
+    void print(std::ostream& os) const override {
+        kind().print(os, kind(), _params.data());
+    }
+
+private:
+    const ShapeKind<T>& kind() const;
+
+    static bool finite(T value) {
+        if constexpr (std::is_floating_point_v<T>) {
+            return std::isfinite(value);
+        } else {
+            return true;
+        }
+    }
+
+    static bool positiveParams(const ShapeKind<T>& shape, const T* params) {
+        for (size_t i = 0; i < shape.stride(); i++) {
+            if (!finite(params[i]) || (i >= 2 && !(params[i] > 0))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    ShapeId _id;
+    std::array<T, kMaxShapeParams> _params;
+};
+
+// Gathers figure i's parameters from the columns; Params is a constant so the loop unrolls and
+// the kernels below read each column with unit stride.
+template <Number T, size_t Params>
+std::array<T, kMaxShapeParams> gatherParams(const T* const* columns, size_t i) {
+    std::array<T, kMaxShapeParams> p{};
+    for (size_t k = 0; k < Params; k++) {
+        p[k] = columns[k][i];
+    }
+    return p;
+}
+
+template <Number T, double (*Area)(const T*), size_t Params>
+void batchAreas(const T* const* columns, size_t first, size_t count, double* out) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = Area(gatherParams<T, Params>(columns, first + i).data());
+    }
+}
+
+// For every point, lowers out[j] to the index of the first figure in the group containing it.
+template <Number T, bool (*Contains)(const T*, double, double), size_t Params>
+void batchClassify(const T* const* columns, const size_t* order, size_t count,
+                   const double* xs, const double* ys, size_t points, size_t* out) {
+    for (size_t f = 0; f < count; f++) {
+        const auto p = gatherParams<T, Params>(columns, f);
+        const size_t index = order[f];
+        for (size_t j = 0; j < points; j++) {
+            bool inside = Contains(p.data(), xs[j], ys[j]);
+            out[j] = (inside && index < out[j]) ? index : out[j];
+        }
+    }
+}
+
+// One kernel instantiation per parameter count, indexed by the kind's stride.
+template <Number T, double (*Area)(const T*), bool (*Contains)(const T*, double, double), size_t... Params>
+void selectKernels(ShapeKind<T>& kind, std::index_sequence<Params...>) {
+    constexpr std::array areas = {batchAreas<T, Area, Params>...};
+    constexpr std::array classify = {batchClassify<T, Contains, Params>...};
+    kind.areas = areas[kind.stride()];
+    kind.classify = classify[kind.stride()];
+}
+
+template <Number T>
+void printShape(std::ostream& os, const ShapeKind<T>& kind, const T* params) {
+    os << kind.name << " (";
+    for (size_t i = 2; i < kind.stride(); i++) {
+        os << kind.params[i] << "=" << params[i];
+        if (i + 1 < kind.stride()) {
+            os << ", ";
+        }
+    }
+    os << ")";
+    for (size_t i = 0; i < kind.vertexCount; i++) {
+        os << kind.vertex(params, i);
+        if (i + 1 < kind.vertexCount) {
+            os << " ";
+        }
+    }
+    os << "Area:" << kind.area(params) << "Center:" << Point<T>(params[0], params[1]);
+}
+
+template <Number T>
+class ShapeRegistry {
+public:
+    static ShapeRegistry& instance() {
+        static ShapeRegistry registry;
+        return registry;
+    }
+
+    // Shapes are expected to be registered at start-up, before figures are created concurrently.
+    // References returned by kind() stay valid across later registrations.
+    ShapeId add(ShapeKind<T> kind) {
+        if (kind.params.size() < 2 || kind.params.size() > kMaxShapeParams) {
+            throw std::invalid_argument("Shape must have between 2 and kMaxShapeParams parameters.");
+        }
+        if (!kind.area || !kind.areas || !kind.vertex || !kind.contains || !kind.classify) {
+            throw std::invalid_argument("Shape must provide area, vertex and containment functions.");
+        }
+        if (find(kind.name)) {
+            throw std::invalid_argument("Shape '" + kind.name + "' is already registered.");
+        }
+
+        if (!kind.print) {
+            kind.print = printShape<T>;
+        }
+        if (!kind.make) {
+            kind.make = [](ShapeId id, const T* params) -> std::shared_ptr<Figure<T>> {
+                return std::make_shared<RegisteredFigure<T>>(id, params);
+            };
+        }
+
+        if (_kinds.size() > std::numeric_limits<ShapeId>::max()) {
+            throw std::length_error("Shape registry is full.");
+        }
+        auto id = static_cast<ShapeId>(_kinds.size());
+        _kinds.push_back(std::move(kind));
+        return id;
+    }
+
+    const ShapeKind<T>& kind(ShapeId id) const {
+        assert(id < _kinds.size());
+        return _kinds[id];
+    }
+
+    size_t size() const {
+        return _kinds.size();
+    }
+
+    std::shared_ptr<Figure<T>> make(ShapeId id, const T* params) const {
+        return kind(id).make(id, params);
+    }
+
+    // Reads a figure written as "Name x y param...", e.g. "Hexagon 0 0 3".
+    std::shared_ptr<Figure<T>> parse(std::istream& in) const {
+        std::string name;
+        if (!(in >> name)) {
+            throw std::invalid_argument("Expected a shape name.");
+        }
+        auto id = find(name);
+        if (!id) {
+            throw std::invalid_argument("Unknown shape '" + name + "'.");
+        }
+
+        const auto& shape = kind(*id);
+        std::array<T, kMaxShapeParams> params{};
+        for (size_t i = 0; i < shape.stride(); i++) {
+            if (!(in >> params[i])) {
+                throw std::invalid_argument("Expected " + shape.params[i] + " for " + name + ".");
+            }
+        }
+        return make(*id, params.data());
+    }
+
+    std::optional<ShapeId> find(const std::string& name) const {
+        for (size_t i = 0; i < _kinds.size(); i++) {
+            if (_kinds[i].name == name) {
+                return static_cast<ShapeId>(i);
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::optional<ShapeId> idOf(const Figure<T>& figure) const {
+        const std::type_info& type = typeid(figure);
+        for (size_t i = 0; i < _kinds.size(); i++) {
+            if (_kinds[i].type && *_kinds[i].type == type) {
+                return static_cast<ShapeId>(i);
+            }
+        }
+        if (auto registered = dynamic_cast<const RegisteredFigure<T>*>(&figure)) {
+            return registered->shapeId();
+        }
+        return std::nullopt;
+    }
+
+    void extract(ShapeId id, const Figure<T>& figure, T* params) const {
+        if (auto registered = dynamic_cast<const RegisteredFigure<T>*>(&figure)) {
+            std::copy(registered->params(), registered->params() + kind(id).stride(), params);
+        } else {
+            kind(id).extract(figure, params);
+        }
+    }
+
+private:
+    ShapeRegistry();
+
+    std::deque<ShapeKind<T>> _kinds;
+};
+
+template <Number T>
+const ShapeKind<T>& RegisteredFigure<T>::kind() const {
+    return ShapeRegistry<T>::instance().kind(_id);
+}
+
+// Builds a kind whose per-shape functions are compiled into the batch kernel instead of
+// being called through a pointer per figure.
+template <Number T, double (*Area)(const T*), Point<T> (*Vertex)(const T*, size_t),
+          bool (*Contains)(const T*, double, double)>
+ShapeKind<T> makeShapeKind(std::string name, std::vector<std::string> params, size_t vertexCount) {
+    ShapeKind<T> kind;
+    kind.name = std::move(name);
+    kind.params = std::move(params);
+    kind.vertexCount = vertexCount;
+    kind.area = Area;
+    kind.vertex = Vertex;
+    kind.contains = Contains;
+    if (kind.stride() <= kMaxShapeParams) {
+        selectKernels<T, Area, Contains>(kind, std::make_index_sequence<kMaxShapeParams + 1>());
+    }
+    return kind;
+}
+
+template <Number T>
+double rhombusArea(const T* p) {
+    return Rhombus<T>::computeArea(p[2], p[3]);
+}
+
+template <Number T>
+Point<T> rhombusVertex(const T* p, size_t index) {
+    return Rhombus<T>::computeVertex(Point<T>(p[0], p[1]), p[2], p[3], index);
+}
+
+template <Number T>
+bool rhombusContains(const T* p, double x, double y) {
+    return Rhombus<T>::computeContains(Point<T>(p[0], p[1]), p[2], p[3], x, y);
+}
+
+template <Number T>
+double pentagonArea(const T* p) {
+    return Pentagon<T>::computeArea(p[2]);
+}
+
+template <Number T>
+Point<T> pentagonVertex(const T* p, size_t index) {
+    return Pentagon<T>::computeVertex(Point<T>(p[0], p[1]), p[2], index);
+}
+
+template <Number T>
+bool pentagonContains(const T* p, double x, double y) {
+    return Pentagon<T>::computeContains(Point<T>(p[0], p[1]), p[2], x, y);
+}
+
+template <Number T>
+double hexagonArea(const T* p) {
+    return Hexagon<T>::computeArea(p[2]);
+}
+
+template <Number T>
+Point<T> hexagonVertex(const T* p, size_t index) {
+    return Hexagon<T>::computeVertex(Point<T>(p[0], p[1]), p[2], index);
+}
+
+template <Number T>
+bool hexagonContains(const T* p, double x, double y) {
+    return Hexagon<T>::computeContains(Point<T>(p[0], p[1]), p[2], x, y);
+}
+
+template <Number T>
+void rhombusPrint(std::ostream& os, const ShapeKind<T>&, const T* p) {
+    Rhombus<T>::computePrint(os, Point<T>(p[0], p[1]), p[2], p[3]);
+}
+
+template <Number T>
+void pentagonPrint(std::ostream& os, const ShapeKind<T>&, const T* p) {
+    Pentagon<T>::computePrint(os, Point<T>(p[0], p[1]), p[2]);
+}
+
+template <Number T>
+void hexagonPrint(std::ostream& os, const ShapeKind<T>&, const T* p) {
+    Hexagon<T>::computePrint(os, Point<T>(p[0], p[1]), p[2]);
+}
+
+template <Number T>
+ShapeRegistry<T>::ShapeRegistry() {
+    auto rhombus = makeShapeKind<T, rhombusArea<T>, rhombusVertex<T>, rhombusContains<T>>(
+        "Rhombus", {"x", "y", "d1", "d2"}, 4);
+    rhombus.type = &typeid(Rhombus<T>);
+    rhombus.make = [](ShapeId, const T* p) -> std::shared_ptr<Figure<T>> {
+        return std::make_shared<Rhombus<T>>(Point<T>(p[0], p[1]), p[2], p[3]);
+    };
+    rhombus.extract = [](const Figure<T>& figure, T* p) {
+        const auto& r = static_cast<const Rhombus<T>&>(figure);
+        p[0] = r.getCenter().getX();
+        p[1] = r.getCenter().getY();
+        p[2] = r.getHorizontalDiagonal();
+        p[3] = r.getVerticalDiagonal();
+    };
+    rhombus.print = rhombusPrint<T>;
+    add(std::move(rhombus));
+
+    auto pentagon = makeShapeKind<T, pentagonArea<T>, pentagonVertex<T>, pentagonContains<T>>(
+        "Pentagon", {"x", "y", "radius"}, 5);
+    pentagon.type = &typeid(Pentagon<T>);
+    pentagon.make = [](ShapeId, const T* p) -> std::shared_ptr<Figure<T>> {
+        return std::make_shared<Pentagon<T>>(Point<T>(p[0], p[1]), p[2]);
+    };
+    pentagon.extract = [](const Figure<T>& figure, T* p) {
+        const auto& f = static_cast<const Pentagon<T>&>(figure);
+        p[0] = f.getCenter().getX();
+        p[1] = f.getCenter().getY();
+        p[2] = f.getRadius();
+    };
+    pentagon.print = pentagonPrint<T>;
+    add(std::move(pentagon));
+
+    auto hexagon = makeShapeKind<T, hexagonArea<T>, hexagonVertex<T>, hexagonContains<T>>(
+        "Hexagon", {"x", "y", "radius"}, 6);
+    hexagon.type = &typeid(Hexagon<T>);
+    hexagon.make = [](ShapeId, const T* p) -> std::shared_ptr<Figure<T>> {
+        return std::make_shared<Hexagon<T>>(Point<T>(p[0], p[1]), p[2]);
+    };
+    hexagon.extract = [](const Figure<T>& figure, T* p) {
+        const auto& f = static_cast<const Hexagon<T>&>(figure);
+        p[0] = f.getCenter().getX();
+        p[1] = f.getCenter().getY();
+        p[2] = f.getRadius();
+    };
+    hexagon.print = hexagonPrint<T>;
+    add(std::move(hexagon));
+}
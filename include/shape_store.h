@@ -0,0 +1,151 @@
+
+#pragma once
+
+#include "array.h"
+#include "radix_sort.h"
+#include "shape_registry.h"
+#include "figure_record.h"
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <span>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+// Structure-of-arrays copy of a figure collection, grouped by shape kind so that bulk
+// operations run one batch kernel per kind instead of one virtual call per figure.
+template <Number T>
+class ShapeStore {
+public:
+    // columns[k] holds parameter k of every figure in the group; order maps them back to the source.
+    struct Group {
+        std::array<std::vector<T>, kMaxShapeParams> columns;
+        std::vector<size_t> order;
+
+        std::array<const T*, kMaxShapeParams> columnPointers() const {
+            std::array<const T*, kMaxShapeParams> pointers;
+            for (size_t k = 0; k < kMaxShapeParams; k++) {
+                pointers[k] = columns[k].data();
+            }
+            return pointers;
+        }
+    };
+
+    static constexpr size_t npos = SIZE_MAX;
+
+    ShapeStore() = default;
+
+    template <Arrayable E>
+    explicit ShapeStore(const Array<E>& figures) {
+        for (const auto& figure : figures) {
+            if (!figure) {
+                throw std::invalid_argument("Cannot store an empty figure.");
+            }
+            add(*figure);
+        }
+    }
+
+    void add(ShapeId id, std::span<const T> params) {
+        const auto& kind = ShapeRegistry<T>::instance().kind(id);
+        if (params.size() != kind.stride()) {
+            throw std::invalid_argument("Parameter count does not match the shape layout.");
+        }
+        auto& group = groupFor(id);
+        for (size_t k = 0; k < params.size(); k++) {
+            group.columns[k].push_back(params[k]);
+        }
+        group.order.push_back(_size++);
+    }
+
+    void add(const Figure<T>& figure) {
+        add(FigureRecord<T>::of(figure));
+    }
+
+    void add(const FigureRecord<T>& record) {
+        add(record.id, std::span<const T>(record.params, record.kind().stride()));
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    const std::vector<Group>& groups() const {
+        return _groups;
+    }
+
+    double totalArea() const {
+        constexpr size_t kBatch = 256;
+        std::array<double, kBatch> areas;
+        double total = 0.0;
+
+        for (size_t id = 0; id < _groups.size(); id++) {
+            const auto& group = _groups[id];
+            const auto& kind = ShapeRegistry<T>::instance().kind(static_cast<ShapeId>(id));
+            const size_t count = group.order.size();
+            const auto columns = group.columnPointers();
+
+            for (size_t first = 0; first < count; first += kBatch) {
+                size_t n = std::min(kBatch, count - first);
+                kind.areas(columns.data(), first, n, areas.data());
+                for (size_t i = 0; i < n; i++) {
+                    total += areas[i];
+                }
+            }
+        }
+        return total;
+    }
+
+    // For every point returns the index of the first figure containing it, or npos.
+    std::vector<size_t> classify(std::span<const Point<T>> points, unsigned threads = 1) const {
+        std::vector<size_t> result(points.size(), npos);
+        threads = std::max(1u, std::min<unsigned>(threads, static_cast<unsigned>(points.size() / kClassifyBlock + 1)));
+        if (threads == 1) {
+            classifyRange(points, result.data());
+            return result;
+        }
+
+        // forEachShare joins every worker and rethrows a kernel's exception on this thread.
+        forEachShare(points.size(), threads, [this, points, &result](unsigned, size_t first, size_t n) {
+            classifyRange(points.subspan(first, n), result.data() + first);
+        });
+        return result;
+    }
+
+private:
+    static constexpr size_t kClassifyBlock = 1024;
+
+    void classifyRange(std::span<const Point<T>> points, size_t* out) const {
+        std::array<double, kClassifyBlock> xs;
+        std::array<double, kClassifyBlock> ys;
+
+        for (size_t first = 0; first < points.size(); first += kClassifyBlock) {
+            size_t n = std::min(kClassifyBlock, points.size() - first);
+            for (size_t j = 0; j < n; j++) {
+                xs[j] = points[first + j].getX();
+                ys[j] = points[first + j].getY();
+            }
+            for (size_t id = 0; id < _groups.size(); id++) {
+                const auto& group = _groups[id];
+                const auto& kind = ShapeRegistry<T>::instance().kind(static_cast<ShapeId>(id));
+                kind.classify(group.columnPointers().data(), group.order.data(), group.order.size(),
+                              xs.data(), ys.data(), n, out + first);
+            }
+        }
+    }
+
+    Group& groupFor(ShapeId id) {
+        if (id >= _groups.size()) {
+            _groups.resize(id + 1);
+        }
+        return _groups[id];
+    }
+
+    std::vector<Group> _groups;
+    size_t _size = 0;
+};
+
+template <Number T, Arrayable E>
+std::vector<size_t> classify(const Array<E>& figures, std::span<const Point<T>> points, unsigned threads = 1) {
+    return ShapeStore<T>(figures).classify(points, threads);
+}
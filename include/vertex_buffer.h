@@ -0,0 +1,147 @@
+
+#pragma once
+
+#include "array.h"
+#include "figure.h"
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+struct VertexRange {
+    size_t firstVertex;
+    size_t vertexCount;
+    size_t firstIndex;
+    size_t indexCount;
+};
+
+// Each figure is written as a triangle fan: a centre vertex followed by its outline.
+// A vertex is interleaved as (x, y, edge), where edge is 0 at the centre and 1 on the outline.
+template <Arrayable E>
+class VertexBufferExporter {
+public:
+    static constexpr size_t kFloatsPerVertex = 3;
+
+    // Indices are 32-bit, so a layout with more than UINT32_MAX vertices is rejected.
+    void layout(const Array<E>& figures) {
+        std::vector<VertexRange> ranges;
+        ranges.reserve(figures.size());
+        size_t vertexCount = 0;
+        size_t indexCount = 0;
+
+        for (const auto& figure : figures) {
+            size_t outline = figure ? std::to_address(figure)->vertexCount() : 0;
+            VertexRange range{vertexCount, outline ? outline + 1 : 0, indexCount, outline * 3};
+            vertexCount += range.vertexCount;
+            indexCount += range.indexCount;
+            if (vertexCount > UINT32_MAX) {
+                throw std::length_error("Layout needs more vertices than 32-bit indices can address.");
+            }
+            ranges.push_back(range);
+        }
+
+        _ranges = std::move(ranges);
+        _dirty.clear();
+        _vertexCount = vertexCount;
+        _indexCount = indexCount;
+    }
+
+    size_t vertexCount() const {
+        return _vertexCount;
+    }
+
+    size_t floatCount() const {
+        return _vertexCount * kFloatsPerVertex;
+    }
+
+    size_t indexCount() const {
+        return _indexCount;
+    }
+
+    const std::vector<VertexRange>& ranges() const {
+        return _ranges;
+    }
+
+    void write(const Array<E>& figures, std::span<float> vertices, std::span<uint32_t> indices) {
+        checkBuffers(figures, vertices, indices);
+        for (size_t i = 0; i < figures.size(); i++) {
+            checkFigure(figures[i], _ranges[i]);
+        }
+        for (size_t i = 0; i < figures.size(); i++) {
+            writeFigure(figures[i], _ranges[i], vertices, indices);
+        }
+        _dirty.clear();
+    }
+
+    void markDirty(size_t index) {
+        if (index >= _ranges.size()) {
+            throw std::out_of_range("Figure index is outside the exported layout.");
+        }
+        _dirty.push_back(index);
+    }
+
+    // Both write() and flush() check every figure before writing any, so a failure leaves the
+    // buffers as they were.
+    void flush(const Array<E>& figures, std::span<float> vertices, std::span<uint32_t> indices) {
+        checkBuffers(figures, vertices, indices);
+        for (size_t i : _dirty) {
+            checkFigure(figures[i], _ranges[i]);
+        }
+        for (size_t i : _dirty) {
+            writeFigure(figures[i], _ranges[i], vertices, indices);
+        }
+        _dirty.clear();
+    }
+
+private:
+    void checkBuffers(const Array<E>& figures, std::span<float> vertices, std::span<uint32_t> indices) const {
+        if (figures.size() != _ranges.size()) {
+            throw std::logic_error("Array size changed, layout() must be called again.");
+        }
+        if (vertices.size() < floatCount() || indices.size() < _indexCount) {
+            throw std::length_error("Vertex or index buffer is too small for the layout.");
+        }
+    }
+
+    // A figure must still have the vertex count it was laid out with; an empty slot counts as 0.
+    static void checkFigure(const E& figure, const VertexRange& range) {
+        size_t outline = figure ? std::to_address(figure)->vertexCount() : 0;
+        if (range.indexCount != outline * 3) {
+            throw std::logic_error("Figure vertex count changed, layout() must be called again.");
+        }
+    }
+
+    static void writeFigure(const E& figure, const VertexRange& range,
+                            std::span<float> vertices, std::span<uint32_t> indices) {
+        if (range.vertexCount == 0) {
+            return;
+        }
+        const auto* shape = std::to_address(figure);
+        float* out = vertices.data() + range.firstVertex * kFloatsPerVertex;
+
+        auto center = shape->getCenter();
+        *out++ = static_cast<float>(center.getX());
+        *out++ = static_cast<float>(center.getY());
+        *out++ = 0.0f;
+        for (const auto& vertex : shape->vertices()) {
+            *out++ = static_cast<float>(vertex.getX());
+            *out++ = static_cast<float>(vertex.getY());
+            *out++ = 1.0f;
+        }
+
+        const size_t outline = range.vertexCount - 1;
+        const auto first = static_cast<uint32_t>(range.firstVertex);
+        uint32_t* idx = indices.data() + range.firstIndex;
+        for (size_t i = 0; i < outline; i++) {
+            *idx++ = first;
+            *idx++ = first + 1 + static_cast<uint32_t>(i);
+            *idx++ = first + 1 + static_cast<uint32_t>((i + 1) % outline);
+        }
+    }
+
+    std::vector<VertexRange> _ranges;
+    std::vector<size_t> _dirty;
+    size_t _vertexCount = 0;
+    size_t _indexCount = 0;
+};
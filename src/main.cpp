@@ -4,12 +4,19 @@
 #include <stdexcept>
 #include <string>
 #include <limits>
+#include <array>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
 #include "point.h"
 #include "figure.h"
 #include "rhombus.h"
 #include "pentagon.h"
 #include "hexagon.h"
 #include "array.h"
+#include "shape_registry.h"
+#include "figure_journal.h"
+#include "profiler.h"
 
 void printMenu() {
     std::cout << "1. Add figure" << std::endl;
@@ -21,16 +28,26 @@ void printMenu() {
     std::cout << "Choose option:";
 }
 
-void addFigureMenu(Array<std::shared_ptr<Figure<double>>>& figures) {
+const size_t kSnapshotInterval = 1000;
+
+Profiler* profiler = nullptr;
+
+LatencyHistogram* profiled(const char* name) {
+    return profiler ? &profiler->histogram(name) : nullptr;
+}
+
+void addFigureMenu(Array<std::shared_ptr<Figure<double>>>& figures, FigureJournal<double>* journal) {
+    const auto& registry = ShapeRegistry<double>::instance();
+
     std::cout << "\nADD FIGURE" << std::endl;
     std::cout << "Choose figure type:" << std::endl;
-    std::cout << "1. Rhombus" << std::endl;
-    std::cout << "2. Pentagon" << std::endl;
-    std::cout << "3. Hexagon" << std::endl;
+    for (size_t id = 0; id < registry.size(); id++) {
+        std::cout << id + 1 << ". " << registry.kind(static_cast<ShapeId>(id)).name << std::endl;
+    }
     std::cout << "0. Back to main menu" << std::endl;
     std::cout << "Choose type:";
     
-    int typeChoice;
+    size_t typeChoice;
     if (!(std::cin >> typeChoice)) {
         std::cin.clear();
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
@@ -39,62 +56,49 @@ void addFigureMenu(Array<std::shared_ptr<Figure<double>>>& figures) {
     }
     
     if (typeChoice == 0) return;
+
+    if (typeChoice > registry.size()) {
+        std::cout << "Invalid figure type!" << std::endl;
+        return;
+    }
+    auto id = static_cast<ShapeId>(typeChoice - 1);
+    const auto& kind = registry.kind(id);
     
-    double centerX, centerY;
+    std::array<double, kMaxShapeParams> params{};
     std::cout << "Enter center coordinates (x y):";
-    if (!(std::cin >> centerX >> centerY)) {
+    if (!(std::cin >> params[0] >> params[1])) {
         std::cin.clear();
         std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
         std::cout << "Invalid coordinates!" << std::endl;
         return;
     }
-    Point<double> center(centerX, centerY);
+
+    std::cout << "Enter";
+    for (size_t i = 2; i < kind.stride(); i++) {
+        std::cout << " " << kind.params[i];
+    }
+    std::cout << ":";
+    for (size_t i = 2; i < kind.stride(); i++) {
+        if (!(std::cin >> params[i])) {
+            std::cin.clear();
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            std::cout << "Invalid parameters!" << std::endl;
+            return;
+        }
+    }
     
     try {
-        switch (typeChoice) {
-            case 1: {
-                double d1, d2;
-                std::cout << "d1 d2 : ";
-                if (!(std::cin >> d1 >> d2)) {
-                    std::cin.clear();
-                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-                    std::cout << "Invalid diagonals!" << std::endl;
-                    return;
-                }
-                figures.push_back(std::make_shared<Rhombus<double>>(center, d1, d2));
-                std::cout << "Rhombus added successfully!" << std::endl;
-                break;
-            }
-            case 2: {
-                double radius;
-                std::cout << "Enter radius: ";
-                if (!(std::cin >> radius)) {
-                    std::cin.clear();
-                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-                    std::cout << "Invalid radius!" << std::endl;
-                    return;
-                }
-                figures.push_back(std::make_shared<Pentagon<double>>(center, radius));
-                std::cout << "Pentagon added successfully!" << std::endl;
-                break;
-            }
-            case 3: {
-                double radius;
-                std::cout << "Enter radius:";
-                if (!(std::cin >> radius)) {
-                    std::cin.clear();
-                    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-                    std::cout << "Invalid radius!" << std::endl;
-                    return;
-                }
-                figures.push_back(std::make_shared<Hexagon<double>>(center, radius));
-                std::cout << "Hexagon added successfully!" << std::endl;
-                break;
-            }
-            default:
-                std::cout << "Invalid figure type!" << std::endl;
-                return;
+        ProfileScope timer(profiled("add"));
+        auto figure = registry.make(id, params.data());
+        {
+            ProfileScope growth(figures.size() == figures.capacity() ? profiled("array.growth") : nullptr);
+            figures.push_back(std::move(figure));
         }
+        if (journal) {
+            journal->recordAdd(*figures[figures.size() - 1]);
+            journal->commit();
+        }
+        std::cout << kind.name << " added successfully!" << std::endl;
     } catch (const std::exception& e) {
         std::cout << "Error creating figure:" << e.what() << std::endl;
     }
@@ -108,17 +112,25 @@ void printAllFigures(Array<std::shared_ptr<Figure<double>>>& figures) {
         return;
     }
     
+    // Formatting goes to a buffer first so that its time is measured apart from terminal output.
+    LatencyHistogram* format = profiled("print.format");
+    LatencyHistogram* output = profiled("print.output");
+    std::ostringstream text;
     for (size_t i = 0; i < figures.size(); ++i) {
-        std::cout << "Figure " << i << ": ";
-        figures[i]->print(std::cout);
-        std::cout << std::endl;
-        std::cout << "  Center: " << figures[i]->getCenter() << std::endl;
-        std::cout << "  Area: " << figures[i]->area() << std::endl;
-        std::cout << std::endl;
+        text.str("");
+        {
+            ProfileScope timer(format);
+            text << "Figure " << i << ": ";
+            figures[i]->print(text);
+            text << "\n  Center: " << figures[i]->getCenter();
+            text << "\n  Area: " << figures[i]->area() << "\n";
+        }
+        ProfileScope timer(output);
+        std::cout << text.str() << std::endl;
     }
 }
 
-void deleteFigureMenu(Array<std::shared_ptr<Figure<double>>>& figures) {
+void deleteFigureMenu(Array<std::shared_ptr<Figure<double>>>& figures, FigureJournal<double>* journal) {
     std::cout << "\nDELETE FIGURE" << std::endl;
     
     if (figures.size() == 0) {
@@ -127,10 +139,13 @@ void deleteFigureMenu(Array<std::shared_ptr<Figure<double>>>& figures) {
     }
     
     std::cout << "Current figures (0 to " << figures.size() - 1 << "):" << std::endl;
-    for (size_t i = 0; i < figures.size(); ++i) {
-        std::cout << i << ": ";
-        figures[i]->print(std::cout);
-        std::cout << std::endl;
+    {
+        ProfileScope timer(profiled("delete.list"));
+        for (size_t i = 0; i < figures.size(); ++i) {
+            std::cout << i << ": ";
+            figures[i]->print(std::cout);
+            std::cout << std::endl;
+        }
     }
     
     std::cout << "Enter index to delete:";
@@ -143,7 +158,12 @@ void deleteFigureMenu(Array<std::shared_ptr<Figure<double>>>& figures) {
     }
     
     if (index < figures.size()) {
+        ProfileScope timer(profiled("delete"));
         figures.erase(index);
+        if (journal) {
+            journal->recordErase(index);
+            journal->commit();
+        }
         std::cout << "Figure at index " << index << " deleted successfully!" << std::endl;
     } else {
         std::cout << "Invalid index!" << std::endl;
@@ -158,8 +178,68 @@ void clearScreen() {
     #endif
 }
 
-int main() {
+// Profiling is enabled by --profile[=report-file] or FIGURES_PROFILE=1|report-file.
+bool profilingRequested(int argc, char* argv[], std::string& reportPath) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--profile") {
+            return true;
+        }
+        if (arg.rfind("--profile=", 0) == 0) {
+            reportPath = arg.substr(10);
+            return true;
+        }
+    }
+
+    const char* env = std::getenv("FIGURES_PROFILE");
+    if (!env || std::string(env).empty() || std::string(env) == "0") {
+        return false;
+    }
+    if (std::string(env) != "1") {
+        reportPath = env;
+    }
+    return true;
+}
+
+void writeProfileReport(const std::string& reportPath) {
+    if (reportPath.empty()) {
+        profiler->report(std::cerr);
+        return;
+    }
+    std::ofstream out(reportPath);
+    if (!out) {
+        std::cerr << "Cannot write profile report to " << reportPath << std::endl;
+        profiler->report(std::cerr);
+        return;
+    }
+    profiler->report(out);
+}
+
+int main(int argc, char* argv[]) {
     Array<std::shared_ptr<Figure<double>>> figures;
+
+    Profiler session;
+    std::string reportPath;
+    if (profilingRequested(argc, argv, reportPath)) {
+        profiler = &session;
+    }
+
+    FigureJournal<double> store("figures.snapshot", "figures.journal");
+    FigureJournal<double>* journal = &store;
+    try {
+        {
+            ProfileScope timer(profiled("recover"));
+            store.recover(figures);
+        }
+        if (figures.size() > 0) {
+            std::cout << "Restored " << figures.size() << " figures." << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cout << "Error restoring figures:" << e.what() << std::endl;
+        std::cout << "Figures will not be saved in this session." << std::endl;
+        figures = Array<std::shared_ptr<Figure<double>>>();
+        journal = nullptr;
+    }
     
     int choice;
     do {
@@ -177,22 +257,29 @@ int main() {
         try {
             switch (choice) {
                 case 1:
-                    addFigureMenu(figures);
+                    addFigureMenu(figures, journal);
                     break;
-                case 2:
+                case 2: {
+                    ProfileScope timer(profiled("print"));
                     printAllFigures(figures);
                     break;
+                }
                 case 3:
                     std::cout << "\nTOTAL AREA" << std::endl;
                     if (figures.size() == 0) {
                         std::cout << "No figures in array." << std::endl;
                     } else {
+                        double total;
+                        {
+                            ProfileScope timer(profiled("totalArea"));
+                            total = figures.totalArea();
+                        }
                         std::cout << "Total area of all " << figures.size() 
-                                  << " figures: " << figures.totalArea() << std::endl;
+                                  << " figures: " << total << std::endl;
                     }
                     break;
                 case 4:
-                    deleteFigureMenu(figures);
+                    deleteFigureMenu(figures, journal);
                     break;
                 case 5:
                     clearScreen();
@@ -201,16 +288,29 @@ int main() {
                     std::cout << "\nEXITING" << std::endl;
                     std::cout << "Final array size:" << figures.size() << std::endl;
                     std::cout << "Final total area:" << figures.totalArea() << std::endl;
+                    if (journal) {
+                        ProfileScope timer(profiled("snapshot"));
+                        journal->snapshot(figures);
+                    }
                     break;
                 default:
                     std::cout << "Invalid option! Please enter a number between 0 and 5." << std::endl;
                     break;
             }
+
+            if (journal && journal->entriesSinceSnapshot() >= kSnapshotInterval) {
+                ProfileScope timer(profiled("snapshot"));
+                journal->snapshot(figures);
+            }
         } catch (const std::exception& e) {
             std::cout << "Error:" << e.what() << std::endl;
         }
         
     } while (choice != 0);
 
+    if (profiler) {
+        writeProfileReport(reportPath);
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,487 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "point.h"
+#include "figure.h"
+#include "rhombus.h"
+#include "pentagon.h"
+#include "hexagon.h"
+#include "array.h"
+#include "vertex_buffer.h"
+#include "shape_registry.h"
+#include "shape_store.h"
+#include "figure_record.h"
+#include "chunked_array.h"
+#include "figure_journal.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace {
+
+const size_t kFigures = 2000;
+const unsigned kSeeds[] = {1, 7, 42};
+
+uint64_t ulpDistance(double a, double b) {
+    if (a == b) {
+        return 0;
+    }
+    auto ordered = [](double v) {
+        int64_t bits = std::bit_cast<int64_t>(v);
+        return bits < 0 ? INT64_MIN - bits : bits;
+    };
+    int64_t x = ordered(a);
+    int64_t y = ordered(b);
+    return x > y ? static_cast<uint64_t>(x) - static_cast<uint64_t>(y) : static_cast<uint64_t>(y) - static_cast<uint64_t>(x);
+}
+
+template <Number T>
+T randomValue(std::mt19937& gen, double low, double high) {
+    if constexpr (std::integral<T>) {
+        return std::uniform_int_distribution<T>(static_cast<T>(low), static_cast<T>(high))(gen);
+    } else {
+        return static_cast<T>(std::uniform_real_distribution<double>(low, high)(gen));
+    }
+}
+
+template <Number T>
+Array<std::shared_ptr<Figure<T>>> randomFigures(unsigned seed, size_t count = kFigures) {
+    std::mt19937 gen(seed);
+    Array<std::shared_ptr<Figure<T>>> figures;
+    for (size_t i = 0; i < count; i++) {
+        Point<T> center(randomValue<T>(gen, -1000, 1000), randomValue<T>(gen, -1000, 1000));
+        switch (gen() % 3) {
+            case 0:
+                figures.push_back(std::make_shared<Rhombus<T>>(center, randomValue<T>(gen, 1, 100), randomValue<T>(gen, 1, 100)));
+                break;
+            case 1:
+                figures.push_back(std::make_shared<Pentagon<T>>(center, randomValue<T>(gen, 1, 100)));
+                break;
+            default:
+                figures.push_back(std::make_shared<Hexagon<T>>(center, randomValue<T>(gen, 1, 100)));
+                break;
+        }
+    }
+    return figures;
+}
+
+template <Number T>
+std::vector<Point<T>> randomPoints(unsigned seed, size_t count) {
+    std::mt19937 gen(seed + 1000);
+    std::vector<Point<T>> points;
+    for (size_t i = 0; i < count; i++) {
+        points.emplace_back(randomValue<T>(gen, -1100, 1100), randomValue<T>(gen, -1100, 1100));
+    }
+    return points;
+}
+
+template <Number T>
+void expectSameVertex(const Point<T>& actual, const Point<T>& expected) {
+    EXPECT_EQ(ulpDistance(actual.getX(), expected.getX()), 0u);
+    EXPECT_EQ(ulpDistance(actual.getY(), expected.getY()), 0u);
+}
+
+
+// Independent reference formulas: baseline closed forms written out here rather than taken from
+// the shape classes, which share computeArea/computeVertex with the registry kernels.
+template <Number T>
+double referenceArea(const Figure<T>& figure) {
+    if (auto r = dynamic_cast<const Rhombus<T>*>(&figure)) {
+        return 0.5 * static_cast<double>(r->getHorizontalDiagonal()) * static_cast<double>(r->getVerticalDiagonal());
+    }
+    if (auto p = dynamic_cast<const Pentagon<T>*>(&figure)) {
+        double r = p->getRadius();
+        return 2.5 * r * r * std::sin(72.0 * M_PI / 180.0);
+    }
+    double r = dynamic_cast<const Hexagon<T>&>(figure).getRadius();
+    return 1.5 * std::sqrt(3.0) * r * r;
+}
+
+template <Number T>
+std::pair<double, double> referenceVertex(const Figure<T>& figure, size_t index) {
+    double cx = figure.getCenter().getX();
+    double cy = figure.getCenter().getY();
+    if (auto r = dynamic_cast<const Rhombus<T>*>(&figure)) {
+        double h = r->getHorizontalDiagonal() / 2.0;
+        double v = r->getVerticalDiagonal() / 2.0;
+        const double dx[] = {0.0, h, 0.0, -h};
+        const double dy[] = {v, 0.0, -v, 0.0};
+        return {cx + dx[index], cy + dy[index]};
+    }
+    double degrees;
+    double r;
+    if (auto p = dynamic_cast<const Pentagon<T>*>(&figure)) {
+        degrees = 72.0 * index - 90.0;
+        r = p->getRadius();
+    } else {
+        degrees = 60.0 * index - 30.0;
+        r = dynamic_cast<const Hexagon<T>&>(figure).getRadius();
+    }
+    return {cx + r * std::cos(degrees * M_PI / 180.0), cy + r * std::sin(degrees * M_PI / 180.0)};
+}
+
+// Largest rounding error of one vertex coordinate: integers truncate (< 1), floating types
+// round once to T (half an ulp of the largest coordinate); both add a few ulps of double trig error.
+template <Number T>
+double vertexTolerance(const Figure<T>& figure) {
+    if constexpr (std::integral<T>) {
+        return 1.0 + 1e-9;
+    } else {
+        double c = std::abs(static_cast<double>(figure.getCenter().getX())) +
+                   std::abs(static_cast<double>(figure.getCenter().getY()));
+        return 4.0 * std::numeric_limits<T>::epsilon() * (c + std::sqrt(figure.area()) + 1.0);
+    }
+}
+
+double shoelaceArea(const std::vector<std::unique_ptr<Point<double>>>& vertices) {
+    double twice = 0.0;
+    for (size_t i = 0; i < vertices.size(); i++) {
+        const auto& a = *vertices[i];
+        const auto& b = *vertices[(i + 1) % vertices.size()];
+        twice += a.getX() * b.getY() - b.getX() * a.getY();
+    }
+    return std::abs(twice) / 2.0;
+}
+
+template <Number T>
+double shoelaceArea(const Figure<T>& figure) {
+    std::vector<std::unique_ptr<Point<double>>> vertices;
+    for (const auto& vertex : figure.getVertices()) {
+        vertices.push_back(std::make_unique<Point<double>>(
+            static_cast<double>(vertex->getX()) - figure.getCenter().getX(),
+            static_cast<double>(vertex->getY()) - figure.getCenter().getY()));
+    }
+    return shoelaceArea(vertices);
+}
+
+}
+
+template <typename T>
+class DifferentialTest : public ::testing::Test {};
+
+using CoordinateTypes = ::testing::Types<int, float, double>;
+TYPED_TEST_SUITE(DifferentialTest, CoordinateTypes);
+
+TYPED_TEST(DifferentialTest, RegistryKernelsMatchClasses) {
+    using T = TypeParam;
+    const auto& registry = ShapeRegistry<T>::instance();
+    for (unsigned seed : kSeeds) {
+        auto figures = randomFigures<T>(seed);
+        for (const auto& figure : figures) {
+            auto record = FigureRecord<T>::of(*figure);
+            const auto& kind = record.kind();
+
+            double batched = 0.0;
+            const T* columns[kMaxShapeParams];
+            for (size_t k = 0; k < kMaxShapeParams; k++) {
+                columns[k] = &record.params[k];
+            }
+            kind.areas(columns, 0, 1, &batched);
+            EXPECT_LE(ulpDistance(kind.area(record.params), figure->area()), 0u);
+            EXPECT_LE(ulpDistance(batched, figure->area()), 0u);
+
+            ASSERT_EQ(kind.vertexCount, figure->vertexCount());
+            auto reference = figure->getVertices();
+            size_t i = 0;
+            for (const auto& vertex : figure->vertices()) {
+                expectSameVertex(vertex, *reference[i]);
+                expectSameVertex(kind.vertex(record.params, i), *reference[i]);
+                i++;
+            }
+
+            auto rebuilt = registry.make(record.id, record.params);
+            EXPECT_TRUE(*rebuilt == *figure);
+            EXPECT_EQ(FigureRecord<T>::of(*rebuilt), record);
+        }
+    }
+}
+
+// The classes and the registry kernels share their formulas, so the test above cannot catch a
+// wrong formula. These checks compare against the reference formulas above instead.
+TYPED_TEST(DifferentialTest, KernelsMatchReferenceFormulas) {
+    using T = TypeParam;
+    for (unsigned seed : kSeeds) {
+        auto figures = randomFigures<T>(seed);
+        for (const auto& figure : figures) {
+            auto record = FigureRecord<T>::of(*figure);
+            const auto& kind = record.kind();
+
+            // Closed forms differ only in operation order: at most 4 ulps of double.
+            double reference = referenceArea(*figure);
+            EXPECT_LE(ulpDistance(kind.area(record.params), reference), 4u) << kind.name;
+            EXPECT_LE(ulpDistance(figure->area(), reference), 4u) << kind.name;
+
+            const double tolerance = vertexTolerance(*figure);
+            for (size_t i = 0; i < kind.vertexCount; i++) {
+                auto [x, y] = referenceVertex(*figure, i);
+                auto vertex = kind.vertex(record.params, i);
+                EXPECT_NEAR(vertex.getX(), x, tolerance) << kind.name << " vertex " << i;
+                EXPECT_NEAR(vertex.getY(), y, tolerance) << kind.name << " vertex " << i;
+            }
+
+            // The polygon through the vertices must enclose the closed-form area. Each vertex is
+            // off by at most the tolerance, which moves the area by at most perimeter * tolerance.
+            if constexpr (std::floating_point<T>) {
+                double perimeter = 0.0;
+                for (size_t i = 0; i < kind.vertexCount; i++) {
+                    auto a = kind.vertex(record.params, i);
+                    auto b = kind.vertex(record.params, (i + 1) % kind.vertexCount);
+                    perimeter += std::hypot(b.getX() - a.getX(), b.getY() - a.getY());
+                }
+                EXPECT_NEAR(shoelaceArea(*figure), reference, 2.0 * perimeter * tolerance) << kind.name;
+            }
+        }
+    }
+}
+
+TYPED_TEST(DifferentialTest, BulkTotalsMatchArray) {
+    using T = TypeParam;
+    for (unsigned seed : kSeeds) {
+        auto figures = randomFigures<T>(seed);
+        const double reference = figures.totalArea();
+        const double bound = figures.size() * std::numeric_limits<double>::epsilon() * reference;
+
+        ShapeStore<T> store(figures);
+        EXPECT_NEAR(store.totalArea(), reference, bound);
+
+        ChunkedArray<FigureRecord<T>, 64> chunked(3);
+        for (const auto& figure : figures) {
+            chunked.push_back(FigureRecord<T>::of(*figure));
+        }
+        EXPECT_EQ(ulpDistance(chunked.totalArea(), reference), 0u);
+
+        chunked.erase(17);
+        figures.erase(17);
+        EXPECT_EQ(ulpDistance(chunked.totalArea(), figures.totalArea()), 0u);
+    }
+}
+
+TYPED_TEST(DifferentialTest, ClassifyMatchesContains) {
+    using T = TypeParam;
+    for (unsigned seed : kSeeds) {
+        auto figures = randomFigures<T>(seed, 300);
+        auto points = randomPoints<T>(seed, 3000);
+        for (size_t i = 0; i < figures.size(); i++) {
+            points.push_back(figures[i]->getCenter());
+            points.push_back(figures[i]->vertexAt(0));
+        }
+
+        auto result = classify(figures, std::span<const Point<T>>(points), 3);
+        for (size_t j = 0; j < points.size(); j++) {
+            size_t expected = ShapeStore<T>::npos;
+            for (size_t i = 0; i < figures.size(); i++) {
+                if (figures[i]->contains(points[j])) {
+                    expected = i;
+                    break;
+                }
+            }
+            EXPECT_EQ(result[j], expected);
+        }
+    }
+}
+
+TYPED_TEST(DifferentialTest, ContainsAgreesWithVertexPolygon) {
+    using T = TypeParam;
+    if constexpr (std::integral<T>) {
+        GTEST_SKIP() << "Integer vertices are truncated and do not describe the exact shape.";
+    } else {
+        for (unsigned seed : kSeeds) {
+            auto figures = randomFigures<T>(seed, 200);
+            auto points = randomPoints<T>(seed, 2000);
+            for (const auto& figure : figures) {
+                for (const auto& point : points) {
+                    bool left = true;
+                    bool right = true;
+                    double margin = 0.0;
+                    for (size_t i = 0; i < figure->vertexCount(); i++) {
+                        auto a = figure->vertexAt(i);
+                        auto b = figure->vertexAt((i + 1) % figure->vertexCount());
+                        double ex = b.getX() - a.getX();
+                        double ey = b.getY() - a.getY();
+                        double cross = ex * (point.getY() - a.getY()) - ey * (point.getX() - a.getX());
+                        double signedDistance = cross / std::hypot(ex, ey);
+                        margin = i == 0 ? std::abs(signedDistance) : std::min(margin, std::abs(signedDistance));
+                        left = left && signedDistance >= 0.0;
+                        right = right && signedDistance <= 0.0;
+                    }
+                    if (margin > 1e-3) {
+                        EXPECT_EQ(figure->contains(point), left || right);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TYPED_TEST(DifferentialTest, VertexBufferMatchesVertices) {
+    using T = TypeParam;
+    auto figures = randomFigures<T>(kSeeds[0], 500);
+    VertexBufferExporter<std::shared_ptr<Figure<T>>> exporter;
+    exporter.layout(figures);
+    std::vector<float> vertices(exporter.floatCount());
+    std::vector<uint32_t> indices(exporter.indexCount());
+    exporter.write(figures, vertices, indices);
+
+    for (size_t i = 0; i < figures.size(); i++) {
+        const auto& range = exporter.ranges()[i];
+        const float* v = vertices.data() + range.firstVertex * exporter.kFloatsPerVertex;
+        EXPECT_EQ(v[0], static_cast<float>(figures[i]->getCenter().getX()));
+        EXPECT_EQ(v[1], static_cast<float>(figures[i]->getCenter().getY()));
+        for (size_t k = 0; k < figures[i]->vertexCount(); k++) {
+            const float* p = v + (k + 1) * exporter.kFloatsPerVertex;
+            EXPECT_EQ(p[0], static_cast<float>(figures[i]->vertexAt(k).getX()));
+            EXPECT_EQ(p[1], static_cast<float>(figures[i]->vertexAt(k).getY()));
+        }
+    }
+}
+
+TYPED_TEST(DifferentialTest, SortMatchesStableSort) {
+    using T = TypeParam;
+    auto figures = randomFigures<T>(kSeeds[1]);
+    std::vector<size_t> expected(figures.size());
+    std::iota(expected.begin(), expected.end(), size_t{0});
+    std::stable_sort(expected.begin(), expected.end(), [&figures](size_t a, size_t b) {
+        return figures[a]->area() < figures[b]->area();
+    });
+    EXPECT_EQ(figures.sortedIndices(), expected);
+
+    std::stable_sort(expected.begin(), expected.end(), [&figures](size_t a, size_t b) {
+        return figures[a]->area() > figures[b]->area();
+    });
+    auto top = figures.topK(25);
+    ASSERT_EQ(top.size(), 25u);
+    for (size_t i = 0; i < top.size(); i++) {
+        EXPECT_EQ(top[i], figures[expected[i]]);
+    }
+}
+
+TYPED_TEST(DifferentialTest, PersistenceRoundTrip) {
+    using T = TypeParam;
+    auto dir = std::filesystem::temp_directory_path() /
+               ("figure_difftest_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    auto figures = randomFigures<T>(kSeeds[2]);
+    {
+        Array<std::shared_ptr<Figure<T>>> empty;
+        FigureJournal<T> journal((dir / "snap").string(), (dir / "log").string());
+        journal.recover(empty);
+        for (size_t i = 0; i < figures.size() / 2; i++) {
+            journal.recordAdd(*figures[i]);
+        }
+        Array<std::shared_ptr<Figure<T>>> half;
+        for (size_t i = 0; i < figures.size() / 2; i++) {
+            half.push_back(figures[i]);
+        }
+        journal.snapshot(half);
+        for (size_t i = figures.size() / 2; i < figures.size(); i++) {
+            journal.recordAdd(*figures[i]);
+        }
+    }
+
+    Array<std::shared_ptr<Figure<T>>> restored;
+    FigureJournal<T> journal((dir / "snap").string(), (dir / "log").string());
+    journal.recover(restored);
+    ASSERT_EQ(restored.size(), figures.size());
+    for (size_t i = 0; i < figures.size(); i++) {
+        EXPECT_TRUE(*restored[i] == *figures[i]);
+        EXPECT_EQ(ulpDistance(restored[i]->area(), figures[i]->area()), 0u);
+    }
+    std::filesystem::remove_all(dir);
+}
+
+TYPED_TEST(DifferentialTest, TextParseRoundTrip) {
+    using T = TypeParam;
+    auto figures = randomFigures<T>(kSeeds[0], 500);
+    std::ostringstream out;
+    out.precision(std::numeric_limits<T>::max_digits10);
+    for (const auto& figure : figures) {
+        auto record = FigureRecord<T>::of(*figure);
+        out << record.kind().name;
+        for (size_t i = 0; i < record.kind().stride(); i++) {
+            out << " " << record.params[i];
+        }
+        out << "\n";
+    }
+
+    std::istringstream in(out.str());
+    for (const auto& figure : figures) {
+        auto parsed = ShapeRegistry<T>::instance().parse(in);
+        EXPECT_EQ(FigureRecord<T>::of(*parsed), FigureRecord<T>::of(*figure));
+    }
+}
+
+TEST(FuzzEntryTest, SurvivesRandomAndMutatedInputs) {
+    auto figures = randomFigures<double>(kSeeds[0], 20);
+    auto dir = std::filesystem::temp_directory_path() / "figure_fuzz_seed";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    {
+        Array<std::shared_ptr<Figure<double>>> empty;
+        FigureJournal<double> journal((dir / "snap").string(), (dir / "log").string());
+        journal.recover(empty);
+        journal.snapshot(figures);
+    }
+    std::ifstream in(dir / "snap", std::ios::binary);
+    std::string snapshot((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::filesystem::remove_all(dir);
+
+    std::vector<std::string> seeds = {
+        std::string(1, '\0') + "Hexagon 0 0 3 Rhombus 1 1 2 2 Pentagon 0 0 -1",
+        std::string(1, '\1') + "Rhombus 1 1 99999999999 2",
+        std::string(1, '\2') + snapshot,
+    };
+
+    std::mt19937 gen(5);
+    for (const auto& seed : seeds) {
+        LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(seed.data()), seed.size());
+        for (int round = 0; round < 200; round++) {
+            std::string mutated = seed;
+            for (int k = 0; k < 4; k++) {
+                mutated[1 + gen() % (mutated.size() - 1)] = static_cast<char>(gen());
+            }
+            mutated.resize(1 + gen() % mutated.size());
+            for (uint8_t selector = 0; selector < 6; selector++) {
+                mutated[0] = static_cast<char>(selector);
+                LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(mutated.data()), mutated.size());
+            }
+        }
+    }
+    SUCCEED();
+}
+
+// Inputs that once reached undefined behaviour in the int vertex paths; run these under
+// -fsanitize=undefined,float-cast-overflow to check them.
+TEST(FuzzEntryTest, RegressionInputs) {
+    const std::string inputs[] = {
+        std::string(1, '\1') + "Rhombus 0 0 2000000000 2000000000",
+        std::string(1, '\1') + "Rhombus 2000000000 0 2000000000 2",
+        std::string(1, '\1') + "Hexagon 2000000000 0 2000000000",
+        std::string(1, '\1') + "Pentagon -2000000000 0 1000000000",
+    };
+    for (const auto& input : inputs) {
+        LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(input.data()), input.size());
+    }
+
+    std::istringstream rhombus("Rhombus 2000000000 0 2000000000 2");
+    EXPECT_THROW(ShapeRegistry<int>::instance().parse(rhombus), std::invalid_argument);
+    std::istringstream hexagon("Hexagon 2000000000 0 2000000000");
+    EXPECT_THROW(ShapeRegistry<int>::instance().parse(hexagon), std::invalid_argument);
+    EXPECT_NO_THROW(Hexagon<int>(Point<int>(2000000000, 0), 147483647));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,74 @@
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include "array.h"
+#include "shape_registry.h"
+#include "figure_journal.h"
+
+namespace {
+
+template <Number T>
+void exercise(const Array<std::shared_ptr<Figure<T>>>& figures) {
+    std::ostringstream sink;
+    for (const auto& figure : figures) {
+        sink << figure->area();
+        figure->print(sink);
+        figure->contains(figure->getCenter());
+    }
+}
+
+template <Number T>
+void fuzzText(const std::string& input) {
+    std::istringstream in(input);
+    Array<std::shared_ptr<Figure<T>>> figures;
+    try {
+        while (in) {
+            figures.push_back(ShapeRegistry<T>::instance().parse(in));
+        }
+    } catch (const std::invalid_argument&) {
+    }
+    exercise(figures);
+}
+
+template <Number T>
+void fuzzSnapshot(const std::string& input) {
+    std::istringstream in(input);
+    Array<std::shared_ptr<Figure<T>>> figures;
+    try {
+        FigureJournal<T>::readSnapshot(in, figures);
+    } catch (const std::runtime_error&) {
+    }
+    exercise(figures);
+}
+
+template <Number T>
+void fuzzJournal(const std::string& input) {
+    std::istringstream in(input);
+    Array<std::shared_ptr<Figure<T>>> figures;
+    try {
+        FigureJournal<T>::replayJournal(in, 0, figures);
+    } catch (const std::runtime_error&) {
+    }
+    exercise(figures);
+}
+
+}
+
+// The first byte selects the parser and coordinate type, the rest is its input.
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    std::string input(reinterpret_cast<const char*>(data) + 1, size - 1);
+
+    switch (data[0] % 6) {
+        case 0: fuzzText<double>(input); break;
+        case 1: fuzzText<int>(input); break;
+        case 2: fuzzSnapshot<double>(input); break;
+        case 3: fuzzSnapshot<int>(input); break;
+        case 4: fuzzJournal<double>(input); break;
+        default: fuzzJournal<float>(input); break;
+    }
+    return 0;
+}
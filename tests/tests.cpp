@@ -5,6 +5,17 @@
 #include "pentagon.h"
 #include "hexagon.h"
 #include "array.h"
+#include "figure_views.h"
+#include "vertex_buffer.h"
+#include "shape_registry.h"
+#include "shape_store.h"
+#include "figure_record.h"
+#include "chunked_array.h"
+#include "figure_journal.h"
+#include "profiler.h"
+#include <filesystem>
+#include <numeric>
+#include <random>
 
 TEST(PointTest, DefaultConstructor) {
     Point<int> p;
@@ -30,6 +41,11 @@ TEST(RhombusTest, AreaCalculation) {
     EXPECT_DOUBLE_EQ(rhombus.area(), 12.0);
 }
 
+TEST(RhombusTest, LargeIntegerDiagonals) {
+    Rhombus<int> rhombus(Point<int>(0, 0), 2000000000, 2000000000);
+    EXPECT_DOUBLE_EQ(rhombus.area(), 2e18);
+}
+
 TEST(RhombusTest, VerticesCount) {
     Point<int> center(0, 0);
     Rhombus<int> rhombus(center, 4, 6);
@@ -128,6 +144,663 @@ TEST(ComparisonTest, FigureEquality) {
     EXPECT_FALSE(rhombus1 == rhombus3); 
 }
 
+TEST(VertexViewTest, MatchesGetVertices) {
+    Point<double> center(1.0, -2.0);
+    Pentagon<double> pentagon(center, 3.0);
+    auto expected = pentagon.getVertices();
+    auto vertices = pentagon.vertices();
+
+    ASSERT_EQ(vertices.size(), expected.size());
+    size_t i = 0;
+    for (const auto& vertex : vertices) {
+        EXPECT_EQ(vertex, *expected[i++]);
+    }
+}
+
+TEST(VertexViewTest, ComposesWithRanges) {
+    Point<int> center(0, 0);
+    Rhombus<int> rhombus(center, 4, 6);
+    auto it = std::ranges::find_if(rhombus.vertices(), [](const Point<int>& p) { return p.getX() > 0; });
+    EXPECT_EQ(*it, Point<int>(2, 0));
+    EXPECT_EQ(std::ranges::distance(rhombus.vertices() | std::views::take(2)), 2);
+}
+
+TEST(FigureViewsTest, FirstHexagonAboveArea) {
+    Array<std::shared_ptr<Figure<double>>> arr;
+    arr.push_back(std::make_shared<Hexagon<double>>(Point<double>(0, 0), 1.0));
+    arr.push_back(std::make_shared<Rhombus<double>>(Point<double>(0, 0), 10.0, 10.0));
+    arr.push_back(std::make_shared<Hexagon<double>>(Point<double>(5, 5), 4.0));
+    arr.push_back(std::make_shared<Hexagon<double>>(Point<double>(9, 9), 5.0));
+
+    auto hexagons = arr | ofType<Hexagon<double>>;
+    auto it = std::ranges::find_if(hexagons, [](const auto& f) { return f->area() > 10.0; });
+    ASSERT_NE(it, hexagons.end());
+    EXPECT_EQ((*it)->getCenter(), Point<double>(5, 5));
+
+    double sum = 0.0;
+    for (double a : arr | ofType<Hexagon<double>> | areas | std::views::take(2)) {
+        sum += a;
+    }
+    EXPECT_DOUBLE_EQ(sum, arr[0]->area() + arr[2]->area());
+}
+
+TEST(ArraySortTest, SortByArea) {
+    Array<std::shared_ptr<Figure<double>>> arr;
+    arr.push_back(std::make_shared<Hexagon<double>>(Point<double>(0, 0), 2.0));
+    arr.push_back(std::make_shared<Rhombus<double>>(Point<double>(0, 0), 1.0, 2.0));
+    arr.push_back(std::make_shared<Pentagon<double>>(Point<double>(0, 0), 3.0));
+    arr.push_back(std::make_shared<Rhombus<double>>(Point<double>(1, 1), 2.0, 1.0));
+
+    arr.sortBy();
+    for (size_t i = 1; i < arr.size(); i++) {
+        EXPECT_LE(arr[i - 1]->area(), arr[i]->area());
+    }
+    EXPECT_EQ(arr[0]->getCenter(), Point<double>(0, 0));
+    EXPECT_EQ(arr[1]->getCenter(), Point<double>(1, 1));
+}
+
+TEST(ArraySortTest, SortedIndicesByCustomKey) {
+    Array<int> arr{5, -3, 0, 12, -7};
+    auto order = arr.sortedIndices([](int v) { return -v; });
+    std::vector<size_t> expected{3, 0, 2, 1, 4};
+    EXPECT_EQ(order, expected);
+}
+
+TEST(ArraySortTest, SignedZeroKeysStayStable) {
+    Array<double> arr{0.0, -0.0, 1.0, -0.0, 0.0, -1.0};
+    std::vector<size_t> expected{5, 0, 1, 3, 4, 2};
+    EXPECT_EQ(arr.sortedIndices([](double v) { return v; }), expected);
+}
+
+TEST(ArraySortTest, ParallelSortMatchesStableSort) {
+    Array<int> arr;
+    std::mt19937 gen(3);
+    for (int i = 0; i < 300000; i++) {
+        arr.push_back(static_cast<int>(gen() % 5000) - 2500);
+    }
+    std::vector<size_t> expected(arr.size());
+    std::iota(expected.begin(), expected.end(), size_t{0});
+    std::stable_sort(expected.begin(), expected.end(), [&arr](size_t a, size_t b) {
+        return arr[a] < arr[b];
+    });
+
+    auto identity = [](int v) { return v; };
+    EXPECT_EQ(arr.sortedIndices(identity, 1), expected);
+    EXPECT_EQ(arr.sortedIndices(identity, 4), expected);
+}
+
+TEST(ArraySortTest, ThrowingKeyPropagatesFromWorkers) {
+    Array<int> arr;
+    for (int i = 0; i < 300000; i++) {
+        arr.push_back(i % 1000);
+    }
+    auto key = [](int v) {
+        if (v == 999) {
+            throw std::runtime_error("bad key");
+        }
+        return v;
+    };
+    EXPECT_THROW(arr.sortedIndices(key, 4), std::runtime_error);
+    EXPECT_THROW(arr.sortBy(key, 4), std::runtime_error);
+    EXPECT_THROW(arr.topK(3, key, 4), std::runtime_error);
+    EXPECT_EQ(arr[0], 0);
+    EXPECT_EQ(arr[999], 999);
+}
+
+TEST(ArraySortTest, TopK) {
+    Array<std::shared_ptr<Figure<double>>> arr;
+    for (int i = 1; i <= 10; i++) {
+        arr.push_back(std::make_shared<Hexagon<double>>(Point<double>(i, 0), i * 0.5));
+    }
+
+    auto top = arr.topK(3);
+    ASSERT_EQ(top.size(), 3);
+    EXPECT_EQ(top[0]->getCenter(), Point<double>(10, 0));
+    EXPECT_EQ(top[1]->getCenter(), Point<double>(9, 0));
+    EXPECT_EQ(top[2]->getCenter(), Point<double>(8, 0));
+    EXPECT_EQ(arr.topK(20).size(), arr.size());
+}
+
+TEST(VertexBufferTest, ExportsTriangleFans) {
+    Array<std::shared_ptr<Figure<double>>> arr;
+    arr.push_back(std::make_shared<Rhombus<double>>(Point<double>(0, 0), 4.0, 6.0));
+    arr.push_back(std::make_shared<Hexagon<double>>(Point<double>(1, 1), 2.0));
+
+    VertexBufferExporter<std::shared_ptr<Figure<double>>> exporter;
+    exporter.layout(arr);
+    EXPECT_EQ(exporter.vertexCount(), 5 + 7);
+    EXPECT_EQ(exporter.indexCount(), 3 * (4 + 6));
+    EXPECT_EQ(exporter.ranges()[1].firstVertex, 5);
+    EXPECT_EQ(exporter.ranges()[1].firstIndex, 12);
+
+    std::vector<float> vertices(exporter.floatCount());
+    std::vector<uint32_t> indices(exporter.indexCount());
+    exporter.write(arr, vertices, indices);
+
+    EXPECT_FLOAT_EQ(vertices[3], 0.0f);
+    EXPECT_FLOAT_EQ(vertices[4], 3.0f);
+    EXPECT_FLOAT_EQ(vertices[5], 1.0f);
+    EXPECT_EQ(indices[12], 5);
+    EXPECT_EQ(indices[indices.size() - 1], 6);
+}
+
+TEST(VertexBufferTest, FlushRewritesOnlyDirtyFigures) {
+    Array<std::shared_ptr<Figure<double>>> arr;
+    arr.push_back(std::make_shared<Pentagon<double>>(Point<double>(0, 0), 1.0));
+    arr.push_back(std::make_shared<Pentagon<double>>(Point<double>(5, 5), 1.0));
+
+    VertexBufferExporter<std::shared_ptr<Figure<double>>> exporter;
+    exporter.layout(arr);
+    std::vector<float> vertices(exporter.floatCount());
+    std::vector<uint32_t> indices(exporter.indexCount());
+    exporter.write(arr, vertices, indices);
+
+    vertices[0] = -100.0f;
+    arr[1] = std::make_shared<Pentagon<double>>(Point<double>(7, 8), 1.0);
+    exporter.markDirty(1);
+    exporter.flush(arr, vertices, indices);
+
+    EXPECT_FLOAT_EQ(vertices[0], -100.0f);
+    EXPECT_FLOAT_EQ(vertices[6 * 3], 7.0f);
+    EXPECT_FLOAT_EQ(vertices[6 * 3 + 1], 8.0f);
+
+    arr[0] = std::make_shared<Pentagon<double>>(Point<double>(-3, 0), 1.0);
+    arr[1] = std::make_shared<Hexagon<double>>(Point<double>(7, 8), 1.0);
+    exporter.markDirty(0);
+    exporter.markDirty(1);
+    EXPECT_THROW(exporter.flush(arr, vertices, indices), std::logic_error);
+    EXPECT_FLOAT_EQ(vertices[0], -100.0f);
+}
+
+TEST(VertexBufferTest, WriteRejectsChangedVertexCount) {
+    Array<std::shared_ptr<Figure<double>>> arr;
+    arr.push_back(std::make_shared<Pentagon<double>>(Point<double>(0, 0), 1.0));
+    arr.push_back(std::make_shared<Pentagon<double>>(Point<double>(5, 5), 1.0));
+
+    VertexBufferExporter<std::shared_ptr<Figure<double>>> exporter;
+    exporter.layout(arr);
+    std::vector<float> vertices(exporter.floatCount(), -1.0f);
+    std::vector<uint32_t> indices(exporter.indexCount());
+
+    arr[1] = std::make_shared<Hexagon<double>>(Point<double>(5, 5), 1.0);
+    EXPECT_THROW(exporter.write(arr, vertices, indices), std::logic_error);
+    arr[1] = nullptr;
+    EXPECT_THROW(exporter.write(arr, vertices, indices), std::logic_error);
+    EXPECT_FLOAT_EQ(vertices[0], -1.0f);
+}
+
+class ManyVerticesFigure : public Figure<double> {
+public:
+    Point<double> getCenter() const override { return Point<double>(); }
+    double area() const override { return 0.0; }
+    size_t vertexCount() const override { return size_t(1) << 31; }
+    Point<double> vertexAt(size_t) const override { return Point<double>(); }
+    bool contains(const Point<double>&) const override { return false; }
+    void print(std::ostream&) const override {}
+};
+
+TEST(VertexBufferTest, LayoutRejectsIndexOverflow) {
+    Array<std::shared_ptr<Figure<double>>> arr;
+    arr.push_back(std::make_shared<Pentagon<double>>(Point<double>(0, 0), 1.0));
+    VertexBufferExporter<std::shared_ptr<Figure<double>>> exporter;
+    exporter.layout(arr);
+
+    arr.push_back(std::make_shared<ManyVerticesFigure>());
+    arr.push_back(std::make_shared<ManyVerticesFigure>());
+    EXPECT_THROW(exporter.layout(arr), std::length_error);
+    EXPECT_EQ(exporter.vertexCount(), 6u);
+}
+
+double squareArea(const double* p) {
+    return p[2] * p[2];
+}
+
+Point<double> squareVertex(const double* p, size_t index) {
+    double h = p[2] / 2.0;
+    double dx = (index == 1 || index == 2) ? h : -h;
+    double dy = (index < 2) ? h : -h;
+    return Point<double>(p[0] + dx, p[1] + dy);
+}
+
+bool squareContains(const double* p, double x, double y) {
+    double h = p[2] / 2.0;
+    return std::abs(x - p[0]) <= h && std::abs(y - p[1]) <= h;
+}
+
+ShapeId squareId() {
+    auto& registry = ShapeRegistry<double>::instance();
+    if (auto id = registry.find("Square")) {
+        return *id;
+    }
+    return registry.add(makeShapeKind<double, squareArea, squareVertex, squareContains>("Square", {"x", "y", "side"}, 4));
+}
+
+TEST(ShapeRegistryTest, BuiltinShapes) {
+    const auto& registry = ShapeRegistry<int>::instance();
+    ASSERT_GE(registry.size(), 3);
+    EXPECT_EQ(registry.kind(*registry.find("Rhombus")).stride(), 4);
+    EXPECT_EQ(registry.kind(*registry.find("Hexagon")).vertexCount, 6);
+
+    Pentagon<int> pentagon(Point<int>(1, 2), 3);
+    EXPECT_EQ(registry.idOf(pentagon), registry.find("Pentagon"));
+}
+
+TEST(ShapeRegistryTest, BuiltinMakeMatchesClass) {
+    const auto& registry = ShapeRegistry<double>::instance();
+    double params[] = {1.0, 2.0, 4.0, 6.0};
+    auto figure = registry.make(*registry.find("Rhombus"), params);
+    EXPECT_TRUE(*figure == Rhombus<double>(Point<double>(1.0, 2.0), 4.0, 6.0));
+    EXPECT_THROW(ShapeRegistry<double>::instance().add(makeShapeKind<double, squareArea, squareVertex, squareContains>("Rhombus", {"x", "y"}, 4)),
+                 std::invalid_argument);
+}
+
+TEST(ShapeRegistryTest, PluginShape) {
+    auto id = squareId();
+    double params[] = {0.0, 0.0, 2.0};
+    auto square = ShapeRegistry<double>::instance().make(id, params);
+
+    EXPECT_DOUBLE_EQ(square->area(), 4.0);
+    EXPECT_EQ(square->vertexAt(1), Point<double>(1.0, 1.0));
+    std::ostringstream os;
+    square->print(os);
+    EXPECT_EQ(os.str().rfind("Square (side=2)", 0), 0);
+}
+
+TEST(ShapeRegistryTest, PluginShapeRejectsInvalidParams) {
+    auto id = squareId();
+    const auto& registry = ShapeRegistry<double>::instance();
+    std::istringstream negative("Square 0 0 -2");
+    EXPECT_THROW(registry.parse(negative), std::invalid_argument);
+    double zero[] = {0.0, 0.0, 0.0};
+    EXPECT_THROW(registry.make(id, zero), std::invalid_argument);
+    double nan[] = {std::numeric_limits<double>::quiet_NaN(), 0.0, 1.0};
+    EXPECT_THROW(registry.make(id, nan), std::invalid_argument);
+}
+
+Point<float> stripVertex(const float* p, size_t index) {
+    return Point<float>(p[0] + (index == 1 || index == 2 ? p[2] : 0.0f), p[1] + (index < 2 ? 1.0f : -1.0f));
+}
+
+bool stripContains(const float* p, double x, double y) {
+    return std::abs(y - p[1]) <= 1.0 && (x - p[0]) * p[2] >= 0.0 && std::abs(x - p[0]) <= std::abs(p[2]);
+}
+
+double stripArea(const float* p) {
+    return std::abs(p[2]) * 2.0;
+}
+
+ShapeId stripId() {
+    auto& registry = ShapeRegistry<float>::instance();
+    if (auto id = registry.find("Strip")) {
+        return *id;
+    }
+    auto kind = makeShapeKind<float, stripArea, stripVertex, stripContains>("Strip", {"x", "y", "length"}, 4);
+    kind.validate = [](const float* p) { return p[2] != 0.0f; };
+    return registry.add(std::move(kind));
+}
+
+TEST(ShapeRegistryTest, KindsSurviveRegistrationAndCustomValidate) {
+    auto& registry = ShapeRegistry<float>::instance();
+    const auto& rhombus = registry.kind(*registry.find("Rhombus"));
+    auto id = stripId();
+    EXPECT_EQ(&rhombus, &registry.kind(*registry.find("Rhombus")));
+    EXPECT_EQ(rhombus.name, "Rhombus");
+    EXPECT_EQ(registry.find("Strip"), id);
+
+    std::istringstream reversed("Strip 0 0 -3");
+    EXPECT_DOUBLE_EQ(registry.parse(reversed)->area(), 6.0);
+    std::istringstream empty("Strip 0 0 0");
+    EXPECT_THROW(registry.parse(empty), std::invalid_argument);
+}
+
+TEST(ShapeRegistryTest, BuiltinPrintMatchesClass) {
+    const auto& registry = ShapeRegistry<double>::instance();
+    const auto& kind = registry.kind(*registry.find("Rhombus"));
+    double params[] = {1.0, 2.0, 4.0, 6.0};
+    std::ostringstream fromParams;
+    kind.print(fromParams, kind, params);
+    std::ostringstream fromClass;
+    Rhombus<double>(Point<double>(1.0, 2.0), 4.0, 6.0).print(fromClass);
+    EXPECT_EQ(fromParams.str(), fromClass.str());
+
+    const auto& hexagon = registry.kind(*registry.find("Hexagon"));
+    double radius[] = {-1.0, 0.5, 3.0};
+    fromParams.str("");
+    hexagon.print(fromParams, hexagon, radius);
+    fromClass.str("");
+    Hexagon<double>(Point<double>(-1.0, 0.5), 3.0).print(fromClass);
+    EXPECT_EQ(fromParams.str(), fromClass.str());
+}
+
+TEST(ShapeStoreTest, TotalAreaMatchesArray) {
+    Array<std::shared_ptr<Figure<double>>> arr;
+    double params[] = {3.0, 3.0, 1.5};
+    arr.push_back(std::make_shared<Rhombus<double>>(Point<double>(0, 0), 4.0, 6.0));
+    arr.push_back(std::make_shared<Hexagon<double>>(Point<double>(1, 1), 2.0));
+    arr.push_back(ShapeRegistry<double>::instance().make(squareId(), params));
+    arr.push_back(std::make_shared<Pentagon<double>>(Point<double>(2, 2), 3.0));
+    arr.push_back(std::make_shared<Rhombus<double>>(Point<double>(0, 0), 1.0, 1.0));
+
+    ShapeStore<double> store(arr);
+    EXPECT_EQ(store.size(), arr.size());
+    EXPECT_EQ(store.groups()[0].order, (std::vector<size_t>{0, 4}));
+    EXPECT_NEAR(store.totalArea(), arr.totalArea(), 1e-12);
+}
+
+TEST(FigureRecordTest, RoundTrip) {
+    Hexagon<float> hexagon(Point<float>(1.5f, -2.0f), 3.0f);
+    auto record = FigureRecord<float>::of(hexagon);
+    EXPECT_FLOAT_EQ(record.area(), hexagon.area());
+    EXPECT_TRUE(*record.toFigure() == hexagon);
+}
+
+TEST(ChunkedArrayTest, EraseAcrossSpilledChunks) {
+    ChunkedArray<int, 4> arr(2);
+    for (int i = 0; i < 30; i++) {
+        arr.push_back(i);
+    }
+    EXPECT_LE(arr.residentChunks(), 2);
+
+    arr.erase(5);
+    arr.erase(0);
+    ASSERT_EQ(arr.size(), 28);
+    for (size_t i = 0; i < arr.size(); i++) {
+        int expected = static_cast<int>(i) + (i < 4 ? 1 : 2);
+        EXPECT_EQ(arr[i], expected);
+    }
+
+    arr[27] = -1;
+    arr.erase(27);
+    arr.erase(26);
+    arr.erase(25);
+    arr.erase(24);
+    arr.push_back(100);
+    EXPECT_EQ(arr.size(), 25);
+    EXPECT_EQ(arr[24], 100);
+    EXPECT_EQ(arr[23], 25);
+    EXPECT_LE(arr.residentChunks(), 2);
+}
+
+TEST(ChunkedArrayTest, TotalAreaMatchesArray) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    ChunkedArray<FigureRecord<double>, 8> records(3);
+    for (int i = 1; i <= 100; i++) {
+        std::shared_ptr<Figure<double>> figure;
+        if (i % 3 == 0) {
+            figure = std::make_shared<Rhombus<double>>(Point<double>(i, 0), i * 0.1, 2.0);
+        } else if (i % 3 == 1) {
+            figure = std::make_shared<Pentagon<double>>(Point<double>(0, i), i * 0.2);
+        } else {
+            figure = std::make_shared<Hexagon<double>>(Point<double>(i, i), i * 0.3);
+        }
+        figures.push_back(figure);
+        records.push_back(FigureRecord<double>::of(*figure));
+    }
+
+    EXPECT_DOUBLE_EQ(records.totalArea(), figures.totalArea());
+    EXPECT_TRUE(*records[7].toFigure() == *figures[7]);
+    EXPECT_LE(records.residentChunks(), 3);
+}
+
+class FigureJournalTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir = std::filesystem::temp_directory_path() /
+              ("figure_journal_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    std::string path(const char* name) const {
+        return (dir / name).string();
+    }
+
+    std::filesystem::path dir;
+};
+
+TEST_F(FigureJournalTest, ReplaysJournalWithoutSnapshot) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    {
+        FigureJournal<double> journal(path("snap"), path("log"));
+        journal.recover(figures);
+        for (int i = 1; i <= 5; i++) {
+            figures.push_back(std::make_shared<Hexagon<double>>(Point<double>(i, 0), i));
+            journal.recordAdd(*figures[figures.size() - 1]);
+        }
+        figures.erase(1);
+        journal.recordErase(1);
+        journal.commit();
+    }
+
+    Array<std::shared_ptr<Figure<double>>> restored;
+    FigureJournal<double> journal(path("snap"), path("log"));
+    journal.recover(restored);
+    ASSERT_EQ(restored.size(), 4);
+    for (size_t i = 0; i < restored.size(); i++) {
+        EXPECT_TRUE(*restored[i] == *figures[i]);
+    }
+    EXPECT_EQ(journal.entriesSinceSnapshot(), 6);
+}
+
+TEST_F(FigureJournalTest, SnapshotThenJournal) {
+    Array<std::shared_ptr<Figure<int>>> figures;
+    {
+        FigureJournal<int> journal(path("snap"), path("log"), 2);
+        journal.recover(figures);
+        figures.push_back(std::make_shared<Rhombus<int>>(Point<int>(0, 0), 4, 6));
+        journal.recordAdd(*figures[0]);
+        journal.snapshot(figures);
+        figures.push_back(std::make_shared<Pentagon<int>>(Point<int>(1, 1), 3));
+        journal.recordAdd(*figures[1]);
+        EXPECT_EQ(journal.pending(), 1);
+    }
+
+    Array<std::shared_ptr<Figure<int>>> restored;
+    FigureJournal<int> journal(path("snap"), path("log"));
+    journal.recover(restored);
+    ASSERT_EQ(restored.size(), 2);
+    EXPECT_TRUE(*restored[0] == *figures[0]);
+    EXPECT_TRUE(*restored[1] == *figures[1]);
+    EXPECT_EQ(journal.entriesSinceSnapshot(), 1);
+}
+
+TEST_F(FigureJournalTest, TornTailIsDiscarded) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    {
+        FigureJournal<double> journal(path("snap"), path("log"));
+        journal.recover(figures);
+        figures.push_back(std::make_shared<Rhombus<double>>(Point<double>(0, 0), 1.0, 2.0));
+        journal.recordAdd(*figures[0]);
+    }
+    {
+        std::ofstream out(path("log"), std::ios::binary | std::ios::app);
+        out << "torn entry";
+    }
+
+    Array<std::shared_ptr<Figure<double>>> restored;
+    {
+        FigureJournal<double> journal(path("snap"), path("log"));
+        journal.recover(restored);
+        ASSERT_EQ(restored.size(), 1);
+        restored.push_back(std::make_shared<Hexagon<double>>(Point<double>(0, 0), 1.0));
+        journal.recordAdd(*restored[1]);
+    }
+
+    FigureJournal<double> journal(path("snap"), path("log"));
+    journal.recover(restored);
+    EXPECT_EQ(restored.size(), 2);
+}
+
+TEST_F(FigureJournalTest, RejectsCorruptSnapshot) {
+    {
+        std::ofstream out(path("snap"), std::ios::binary);
+        out << "not a snapshot";
+    }
+    Array<std::shared_ptr<Figure<double>>> figures;
+    FigureJournal<double> journal(path("snap"), path("log"));
+    EXPECT_THROW(journal.recover(figures), std::runtime_error);
+}
+
+TEST_F(FigureJournalTest, RejectsJournalNewerThanSnapshot) {
+    Array<std::shared_ptr<Figure<double>>> figures;
+    {
+        FigureJournal<double> journal(path("snap"), path("log"));
+        journal.recover(figures);
+        figures.push_back(std::make_shared<Rhombus<double>>(Point<double>(0, 0), 1.0, 2.0));
+        journal.recordAdd(*figures[0]);
+        journal.snapshot(figures);
+        std::filesystem::copy_file(path("snap"), path("snap.old"));
+
+        figures.push_back(std::make_shared<Hexagon<double>>(Point<double>(0, 0), 1.0));
+        journal.recordAdd(*figures[1]);
+        journal.snapshot(figures);
+        figures.push_back(std::make_shared<Pentagon<double>>(Point<double>(0, 0), 1.0));
+        journal.recordAdd(*figures[2]);
+    }
+    // Simulates a lost rename: the generation 2 journal sits next to the generation 1 snapshot.
+    std::filesystem::rename(path("snap.old"), path("snap"));
+    const auto journalSize = std::filesystem::file_size(path("log"));
+
+    Array<std::shared_ptr<Figure<double>>> restored;
+    {
+        FigureJournal<double> journal(path("snap"), path("log"));
+        EXPECT_THROW(journal.recover(restored), std::runtime_error);
+    }
+    EXPECT_EQ(std::filesystem::file_size(path("log")), journalSize);
+
+    std::filesystem::remove(path("snap"));
+    FigureJournal<double> journal(path("snap"), path("log"));
+    EXPECT_THROW(journal.recover(restored), std::runtime_error);
+    EXPECT_EQ(std::filesystem::file_size(path("log")), journalSize);
+}
+
+TEST(ContainsTest, Rhombus) {
+    Rhombus<double> rhombus(Point<double>(1, 1), 4.0, 2.0);
+    EXPECT_TRUE(rhombus.contains(Point<double>(1, 1)));
+    EXPECT_TRUE(rhombus.contains(Point<double>(3, 1)));
+    EXPECT_TRUE(rhombus.contains(Point<double>(2, 1.5)));
+    EXPECT_FALSE(rhombus.contains(Point<double>(2, 1.6)));
+    EXPECT_FALSE(rhombus.contains(Point<double>(1, 2.1)));
+}
+
+TEST(ContainsTest, RegularPolygons) {
+    Pentagon<double> pentagon(Point<double>(0, 0), 2.0);
+    Hexagon<double> hexagon(Point<double>(5, 5), 2.0);
+
+    for (const auto& vertex : pentagon.vertices()) {
+        EXPECT_TRUE(pentagon.contains(vertex));
+        EXPECT_FALSE(pentagon.contains(Point<double>(vertex.getX() * 1.01, vertex.getY() * 1.01)));
+    }
+    for (size_t i = 0; i < hexagon.vertexCount(); i++) {
+        auto a = hexagon.vertexAt(i);
+        auto b = hexagon.vertexAt((i + 1) % hexagon.vertexCount());
+        double mx = (a.getX() + b.getX()) / 2.0 - 5.0;
+        double my = (a.getY() + b.getY()) / 2.0 - 5.0;
+        EXPECT_TRUE(hexagon.contains(Point<double>(5.0 + mx * 0.999, 5.0 + my * 0.999)));
+        EXPECT_FALSE(hexagon.contains(Point<double>(5.0 + mx * 1.001, 5.0 + my * 1.001)));
+    }
+}
+
+TEST(ClassifyTest, MatchesPerFigureContains) {
+    Array<std::shared_ptr<Figure<double>>> arr;
+    double params[] = {-3.0, -3.0, 2.0};
+    arr.push_back(std::make_shared<Hexagon<double>>(Point<double>(0, 0), 3.0));
+    arr.push_back(std::make_shared<Rhombus<double>>(Point<double>(2, 0), 4.0, 4.0));
+    arr.push_back(ShapeRegistry<double>::instance().make(squareId(), params));
+    arr.push_back(std::make_shared<Pentagon<double>>(Point<double>(-2, 2), 2.5));
+
+    std::vector<Point<double>> points;
+    for (int i = 0; i < 5000; i++) {
+        points.emplace_back(-6.0 + (i % 100) * 0.12, -6.0 + (i / 100) * 0.24);
+    }
+
+    for (unsigned threads : {1u, 4u}) {
+        auto result = classify(arr, std::span<const Point<double>>(points), threads);
+        ASSERT_EQ(result.size(), points.size());
+        for (size_t j = 0; j < points.size(); j++) {
+            size_t expected = ShapeStore<double>::npos;
+            for (size_t i = 0; i < arr.size(); i++) {
+                if (arr[i]->contains(points[j])) {
+                    expected = i;
+                    break;
+                }
+            }
+            EXPECT_EQ(result[j], expected);
+        }
+    }
+}
+
+bool faultyContains(const double* p, double x, double y) {
+    if (x > 5.0) {
+        throw std::runtime_error("contains failed");
+    }
+    return squareContains(p, x, y);
+}
+
+ShapeId faultyId() {
+    auto& registry = ShapeRegistry<double>::instance();
+    if (auto id = registry.find("FaultySquare")) {
+        return *id;
+    }
+    return registry.add(makeShapeKind<double, squareArea, squareVertex, faultyContains>("FaultySquare", {"x", "y", "side"}, 4));
+}
+
+TEST(ClassifyTest, KernelExceptionPropagatesFromWorkers) {
+    Array<std::shared_ptr<Figure<double>>> arr;
+    double params[] = {0.0, 0.0, 2.0};
+    arr.push_back(ShapeRegistry<double>::instance().make(faultyId(), params));
+
+    std::vector<Point<double>> points;
+    for (int i = 0; i < 5000; i++) {
+        points.emplace_back(i * 0.002, 0.0);
+    }
+    EXPECT_THROW(classify(arr, std::span<const Point<double>>(points), 4), std::runtime_error);
+}
+
+TEST(LatencyHistogramTest, PercentilesWithinBucketPrecision) {
+    LatencyHistogram histogram;
+    for (uint64_t v = 1; v <= 10000; v++) {
+        histogram.record(v * 1000);
+    }
+
+    EXPECT_EQ(histogram.count(), 10000);
+    EXPECT_EQ(histogram.min(), 1000);
+    EXPECT_EQ(histogram.max(), 10000000);
+    EXPECT_DOUBLE_EQ(histogram.mean(), 5000500.0);
+    EXPECT_NEAR(histogram.percentile(50), 5000000.0, 5000000.0 / 16);
+    EXPECT_NEAR(histogram.percentile(99), 9900000.0, 9900000.0 / 16);
+    EXPECT_EQ(histogram.percentile(100), 10000000);
+}
+
+TEST(LatencyHistogramTest, ExtremeValues) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.percentile(50), 0);
+    histogram.record(0);
+    histogram.record(std::numeric_limits<uint64_t>::max());
+    EXPECT_EQ(histogram.percentile(0), 0);
+    EXPECT_EQ(histogram.percentile(100), std::numeric_limits<uint64_t>::max());
+}
+
+TEST(ProfilerTest, ScopesRecordIntoNamedHistograms) {
+    Profiler profiler;
+    {
+        ProfileScope timer(&profiler.histogram("add"));
+    }
+    {
+        ProfileScope disabled(nullptr);
+    }
+    EXPECT_EQ(profiler.histogram("add").count(), 1);
+
+    std::ostringstream os;
+    profiler.report(os);
+    EXPECT_NE(os.str().find("add"), std::string::npos);
+    EXPECT_EQ(os.str().find("delete"), std::string::npos);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();